@@ -6,17 +6,17 @@ component "ParentOffset" {
     additional_schema = [[
         CREATE INDEX ParentOffset_is_dirty ON ParentOffset(is_dirty);
 
+        -- The whole subtree is marked, so nested offsets are resolved in a single pass
         CREATE TRIGGER ParentOffset_Position_updated
         AFTER UPDATE ON Position
         BEGIN
             UPDATE ParentOffset
             SET is_dirty = TRUE
-            FROM (
-                SELECT id
-                FROM entity
-                WHERE parent_id = new.entity_id
-            ) AS t
-            WHERE ParentOffset.entity_id = t.id;
+            WHERE entity_id IN (
+                SELECT descendant_id
+                FROM entity_closure
+                WHERE ancestor_id = new.entity_id AND depth > 0
+            );
         END;
 
         CREATE TRIGGER ParentOffset_Rotation_updated
@@ -24,12 +24,11 @@ component "ParentOffset" {
         BEGIN
             UPDATE ParentOffset
             SET is_dirty = TRUE
-            FROM (
-                SELECT id
-                FROM entity
-                WHERE parent_id = new.entity_id
-            ) AS t
-            WHERE ParentOffset.entity_id = t.id;
+            WHERE entity_id IN (
+                SELECT descendant_id
+                FROM entity_closure
+                WHERE ancestor_id = new.entity_id AND depth > 0
+            );
         END;
     ]]
 }
@@ -2,6 +2,7 @@ system "UpdateParentOffset" {
     [[
         SELECT
             ParentOffset.entity_id AS entity_id,
+            parent_id,
             ParentOffset.x AS local_x,
             ParentOffset.y AS local_y,
             parent_position.x AS parent_x,
@@ -12,6 +13,8 @@ system "UpdateParentOffset" {
             JOIN Position AS parent_position ON parent_position.entity_id = parent_id
             LEFT JOIN Rotation AS parent_rotation ON parent_rotation.entity_id = parent_id
         WHERE is_dirty
+        -- Parents first, so that children use their updated positions
+        ORDER BY (SELECT count(*) FROM entity_closure WHERE descendant_id = ParentOffset.entity_id)
     ]],
     [[
         INSERT INTO Position(entity_id, x, y)
@@ -24,12 +27,19 @@ system "UpdateParentOffset" {
         ON CONFLICT DO UPDATE SET z = ?2
     ]],
     function(select_values, update_position, update_rotation)
+        -- Rows are sorted before the loop runs, so parents updated in this pass are read from here
+        local updated = {}
         for row in select_values() do
-            local entity_id, local_x, local_y, parent_x, parent_y, rotation = row:unpack()
+            local entity_id, parent_id, local_x, local_y, parent_x, parent_y, rotation = row:unpack()
+            local parent = updated[parent_id]
+            if parent then
+                parent_x, parent_y, rotation = parent[1], parent[2], parent[3]
+            end
             local local_position = Vector2(local_x, local_y):rotated(rotation * DEG2RAD)
-            local global_position = Vector2(parent_x, parent_y) + local_position
-            update_position(entity_id, global_position:unpack())
+            local global_x, global_y = (Vector2(parent_x, parent_y) + local_position):unpack()
+            update_position(entity_id, global_x, global_y)
             update_rotation(entity_id, rotation)
+            updated[entity_id] = { global_x, global_y, rotation }
         end
     end,
     use_fixed_delta = true,
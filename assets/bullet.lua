@@ -9,14 +9,37 @@ FROM Position
 WHERE entity_id = ?
 ]], true)
 
+prefab "Bullet" {
+    Sprite = {
+        path = "ballGrey_08",
+    },
+    Position = {},
+    Rotation = {},
+    DestroyOnOutOfScreen = {},
+    Body = {
+        type = "dynamic",
+    },
+    Shape = {
+        restitution = 1,
+    },
+    Size = {
+        width = tuning.BULLET_RADIUS * 2,
+        height = tuning.BULLET_RADIUS * 2,
+    },
+    Circle = {
+        radius = tuning.BULLET_RADIUS,
+    },
+    LinearImpulse = {},
+    DeleteAfter = {
+        seconds = tuning.BULLET_LIFETIME,
+    },
+}
+
 return function(parent_id)
     local x, y, rotation = get_position(parent_id):unpack()
     local offset = Vector2(0, -50):rotated(rotation * DEG2RAD)
     local impulse = Vector2(0, -100000):rotated(rotation * DEG2RAD)
-    return entity "Bullet" {
-        Sprite = {
-            path = "ballGrey_08",
-        },
+    return (instantiate("Bullet", 1, {
         Position = {
             x = x + offset.x,
             y = y + offset.y,
@@ -24,26 +47,9 @@ return function(parent_id)
         Rotation = {
             z = rotation,
         },
-        DestroyOnOutOfScreen = {},
-        Body = {
-            type = "dynamic",
-        },
-        Shape = {
-            restitution = 1,
-        },
-        Size = {
-            width = tuning.BULLET_RADIUS * 2,
-            height = tuning.BULLET_RADIUS * 2,
-        },
-        Circle = {
-            radius = tuning.BULLET_RADIUS,
-        },
         LinearImpulse = {
             x = impulse.x,
             y = impulse.y,
         },
-        DeleteAfter = {
-            seconds = tuning.BULLET_LIFETIME,
-        },
-    }
+    }))
 end
@@ -0,0 +1,132 @@
+#include <array>
+#include <chrono>
+#include <iostream>
+
+#include "../src/ecsql/component.hpp"
+#include "../src/ecsql/component_cache.hpp"
+#include "../src/ecsql/query.hpp"
+#include "../src/ecsql/world.hpp"
+
+// Compares iterating a component through SQL, through batched Query fetches and through its ComponentCache mirror
+struct BenchPosition {
+	double x;
+	double y;
+	double z;
+};
+
+static const int ITERATIONS = 20;
+
+static const char populate_sql[] = R"(
+	WITH RECURSIVE ids(id) AS (
+		SELECT 1
+		UNION ALL
+		SELECT id + 1 FROM ids WHERE id < ?
+	)
+	INSERT INTO entity(id) SELECT id FROM ids
+)";
+
+ecsql::Component BenchPositionComponent {
+	"BenchPosition",
+	{
+		"x NOT NULL DEFAULT 0",
+		"y NOT NULL DEFAULT 0",
+		"z NOT NULL DEFAULT 0",
+	}
+};
+
+template<typename Fn>
+static double measure_ms(Fn&& f) {
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < ITERATIONS; i++) {
+		f();
+	}
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count() / ITERATIONS;
+}
+
+static void populate(ecsql::World& world, int entity_count) {
+	world.inside_transaction([&]() {
+		world.execute_sql(populate_sql, entity_count);
+		world.execute_sql("INSERT INTO BenchPosition(entity_id, x, y, z) SELECT id, id, id * 2, 0 FROM entity");
+	});
+}
+
+static void run_benchmark(int entity_count) {
+	ecsql::World sql_world(":memory:", ":memory:");
+	sql_world.register_component(BenchPositionComponent);
+	populate(sql_world, entity_count);
+
+	// Declared before the world, whose destructor still runs the cache's hook
+	ecsql::ComponentCache<BenchPosition> cache;
+	ecsql::World cached_world(":memory:", ":memory:");
+	cached_world.register_component(BenchPositionComponent);
+	cached_world.register_hook_system(cache.hook_system);
+	populate(cached_world, entity_count);
+
+	ecsql::PreparedSQL select_positions = sql_world.prepare_sql("SELECT x, y, z FROM BenchPosition", true);
+	double sql_sum = 0;
+	double sql_read_ms = measure_ms([&]() {
+		for (ecsql::SQLRow row : select_positions()) {
+			auto position = row.get<BenchPosition>();
+			sql_sum += position.x + position.y + position.z;
+		}
+	});
+
+	ecsql::Query<BenchPosition> query_positions(sql_world.get_db().get(), "SELECT x, y, z FROM BenchPosition");
+	double batch_sum = 0;
+	double batch_read_ms = measure_ms([&]() {
+		std::array<BenchPosition, 256> batch;
+		query_positions();
+		while (size_t count = query_positions.fetch_batch(batch)) {
+			for (size_t i = 0; i < count; i++) {
+				batch_sum += batch[i].x + batch[i].y + batch[i].z;
+			}
+		}
+	});
+
+	ecsql::Query<double, double, double> query_soa(sql_world.get_db().get(), "SELECT x, y, z FROM BenchPosition");
+	double soa_sum = 0;
+	double soa_read_ms = measure_ms([&]() {
+		auto [xs, ys, zs] = query_soa().fetch_all_soa();
+		for (size_t i = 0; i < xs.size(); i++) {
+			soa_sum += xs[i] + ys[i] + zs[i];
+		}
+	});
+
+	double cache_sum = 0;
+	double cache_read_ms = measure_ms([&]() {
+		auto xs = cache.field<0>();
+		auto ys = cache.field<1>();
+		auto zs = cache.field<2>();
+		for (size_t i = 0; i < cache.size(); i++) {
+			cache_sum += xs[i] + ys[i] + zs[i];
+		}
+	});
+
+	// Writes pay for mirroring rows into the cache
+	double sql_write_ms = measure_ms([&]() {
+		sql_world.inside_transaction([&]() {
+			sql_world.execute_sql("UPDATE BenchPosition SET x = x + 1");
+		});
+	});
+	double cache_write_ms = measure_ms([&]() {
+		cached_world.inside_transaction([&]() {
+			cached_world.execute_sql("UPDATE BenchPosition SET x = x + 1");
+		});
+	});
+
+	std::cout << entity_count << " entities" << std::endl
+		<< "  read  SQL:   " << sql_read_ms << " ms" << std::endl
+		<< "  read  batch: " << batch_read_ms << " ms" << std::endl
+		<< "  read  SoA:   " << soa_read_ms << " ms" << std::endl
+		<< "  read  cache: " << cache_read_ms << " ms" << std::endl
+		<< "  write SQL:   " << sql_write_ms << " ms" << std::endl
+		<< "  write cache: " << cache_write_ms << " ms" << std::endl
+		<< "  (checksums " << sql_sum << " / " << batch_sum << " / " << soa_sum << " / " << cache_sum << ")" << std::endl;
+}
+
+int main(int argc, const char **argv) {
+	run_benchmark(10'000);
+	run_benchmark(100'000);
+	return 0;
+}
@@ -0,0 +1,215 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <physfs.h>
+#include <sol/sol.hpp>
+
+#include "game_schema.h"
+#include "../src/assetio.hpp"
+#include "../src/memory.hpp"
+#include "../src/screen.hpp"
+#include "../src/snapshot.hpp"
+#include "../src/sqlite_functions.hpp"
+#include "../src/ecsql/additional_sql.hpp"
+#include "../src/ecsql/batched_hook_system.hpp"
+#include "../src/ecsql/component.hpp"
+#include "../src/ecsql/hook_system.hpp"
+#include "../src/ecsql/world.hpp"
+#include "../src/physics/physics.hpp"
+#include "../src/scripting/lua_scripting.hpp"
+#include "../src/systems/key_handler.hpp"
+#include "../src/systems/spatial_index.hpp"
+#include "../src/systems/yoga.hpp"
+
+// Headless whole-frame benchmark.
+// Sets up the world like `game_main`, except for the window and draw systems,
+// spawns physics driven entities and reports per-frame and per-system timings.
+//
+// Also reports compressed snapshot size and save/load latency after the last frame.
+//
+// When an allocation budget is given, profiling is disabled and the program fails
+// if any frame after warm-up calls `operator new` more times than the budget.
+//
+// Usage: ecsql_bench [entity_count] [frame_count] [allocation_budget]
+
+static const int DEFAULT_ENTITY_COUNT = 1000;
+static const int DEFAULT_FRAME_COUNT = 600;
+static const int WARMUP_FRAME_COUNT = 60;
+static const float FIXED_DELTA_TIME = 1.0f / 60.0f;
+static const int SCREEN_WIDTH = 800;
+static const int SCREEN_HEIGHT = 600;
+static const char SNAPSHOT_FILE_NAME[] = "frame_bench_snapshot.dat";
+
+// No sprites here: their flyweights need a graphics context to load textures
+static const char scene_script[] = R"(
+	local entity_count, width, height = ...
+	require "physics"
+	for i = 1, entity_count do
+		entity {
+			Position = {
+				x = math.random(0, width),
+				y = math.random(0, height),
+			},
+			MoveVector = {
+				x = math.random(-50, 50),
+				y = math.random(-50, 50),
+			},
+			Body = {
+				type = "dynamic",
+			},
+			Shape = {},
+			Circle = {
+				radius = 4,
+			},
+		}
+	end
+)";
+
+static double percentile(std::vector<double>& samples, double p) {
+	if (samples.empty()) {
+		return 0;
+	}
+	std::sort(samples.begin(), samples.end());
+	size_t index = std::min(samples.size() - 1, (size_t) (p * (samples.size() - 1) + 0.5));
+	return samples[index];
+}
+
+int main(int argc, const char **argv) {
+	int entity_count = argc >= 2 ? std::atoi(argv[1]) : DEFAULT_ENTITY_COUNT;
+	int frame_count = argc >= 3 ? std::atoi(argv[2]) : DEFAULT_FRAME_COUNT;
+	int allocation_budget = argc >= 4 ? std::atoi(argv[3]) : -1;
+
+	configure_memory_hooks();
+	assetio::assetio_initialize(argv[0], "com.gilzoide", "ecsql");
+	PHYSFS_mount(ECSQL_ASSETS_DIR, nullptr, 0);
+
+	ecsql::World world(":memory:", ":memory:");
+	world.execute_sql_script(game_schema);
+	world.execute_sql(screen::update_sql, SCREEN_WIDTH, SCREEN_HEIGHT);
+	world.register_connection_setup(register_sqlite_functions);
+
+	// Components
+	ecsql::Component::foreach_static_linked_list([&](ecsql::Component *component) {
+		world.register_component(*component);
+	});
+	ecsql::HookSystem::foreach_static_linked_list([&](ecsql::HookSystem *system) {
+		world.register_hook_system(*system);
+	});
+	ecsql::BatchedHookSystem::foreach_static_linked_list([&](ecsql::BatchedHookSystem *system) {
+		world.register_hook_system(*system);
+	});
+	ecsql::AdditionalSQL::foreach_static_linked_list([&](ecsql::AdditionalSQL *additional_sql) {
+		world.execute_sql_script(additional_sql->get_sql().c_str());
+	});
+
+	// Systems
+	register_key_handler(world);
+	register_update_yoga(world);
+	register_spatial_index(world);
+
+	LuaScripting lua(world);
+	Physics physics(world);
+
+	assetio::foreach_file("autoload", [&](const std::filesystem::path& path) {
+		assetio::do_lua_script(lua, path.c_str());
+	}, true);
+
+	// Scene
+	bool loaded_scene = world.inside_transaction([&]() {
+		sol::state_view state = lua;
+		sol::protected_function scene = state.load(scene_script, "=frame_bench_scene");
+		auto result = scene(entity_count, SCREEN_WIDTH, SCREEN_HEIGHT);
+		if (!result.valid()) {
+			throw result.get<sol::error>();
+		}
+	});
+	if (!loaded_scene) {
+		std::cerr << "Could not load benchmark scene. Bailing out." << std::endl;
+		return 1;
+	}
+
+	// Frames
+	// The profiler allocates its reports every frame, so it is left out when checking allocations
+	bool check_allocations = allocation_budget >= 0;
+	world.set_profiling_enabled(!check_allocations);
+	std::vector<double> frame_times;
+	std::vector<uint64_t> frame_allocations;
+	std::map<std::string, std::vector<double>> system_times;
+	frame_times.reserve(frame_count);
+	frame_allocations.reserve(frame_count);
+	for (int i = 0; i < frame_count; i++) {
+		uint64_t allocations_before = get_allocation_count();
+		auto start = std::chrono::steady_clock::now();
+		world.update(FIXED_DELTA_TIME);
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		frame_allocations.push_back(get_allocation_count() - allocations_before);
+		frame_times.push_back(elapsed.count());
+		if (!check_allocations) {
+			for (const ecsql::SystemProfile& profile : world.get_system_profiles()) {
+				system_times[profile.name].push_back(profile.time_ms);
+			}
+		}
+	}
+
+	// Report
+	std::cout << entity_count << " entities, " << frame_count << " frames" << std::endl;
+	std::cout << "frame: p50 " << percentile(frame_times, 0.5) << " ms, p99 " << percentile(frame_times, 0.99) << " ms" << std::endl;
+	for (auto&& [name, times] : system_times) {
+		std::cout << "  " << name << ": p50 " << percentile(times, 0.5) << " ms, p99 " << percentile(times, 0.99) << " ms" << std::endl;
+	}
+
+	uint64_t max_allocations = 0;
+	int frames_over_budget = 0;
+	for (int i = WARMUP_FRAME_COUNT; i < frame_allocations.size(); i++) {
+		max_allocations = std::max(max_allocations, frame_allocations[i]);
+		if (check_allocations && frame_allocations[i] > (uint64_t) allocation_budget) {
+			frames_over_budget++;
+		}
+	}
+	std::cout << "allocations per frame after warm-up: max " << max_allocations << std::endl;
+
+	MemoryStats memory = get_memory_stats(world.get_db().get());
+	std::cout << "memory:" << std::endl
+		<< "  pagecache: " << memory.pagecache_highwater << "/" << memory.pagecache_slots << " slots at most, " << memory.pagecache_overflow_bytes << " overflow bytes" << std::endl
+		<< "  lookaside: " << memory.lookaside_hits << " hits, " << memory.lookaside_misses_size << " size misses, " << memory.lookaside_misses_full << " full misses" << std::endl
+		<< "  page cache: " << memory.cache_hits << " hits, " << memory.cache_misses << " misses" << std::endl
+		<< "  lua: " << memory.lua_pool_allocations << " pooled, " << memory.lua_fallback_allocations << " malloc, " << memory.lua_pool_bytes << " pool bytes" << std::endl
+		<< "  box2d: " << memory.box2d_allocations << " allocations, " << memory.box2d_live_allocations << " live" << std::endl;
+
+	// Snapshots, saved through the same asynchronous path as the game
+	auto save_start = std::chrono::steady_clock::now();
+	std::future<bool> save_result = snapshot::save_async(world, SNAPSHOT_FILE_NAME);
+	std::chrono::duration<double, std::milli> save_blocking_time = std::chrono::steady_clock::now() - save_start;
+	bool saved_snapshot = save_result.get();
+	std::chrono::duration<double, std::milli> save_total_time = std::chrono::steady_clock::now() - save_start;
+
+	// Compression alone, measured in this thread, also provides the data for timing loads
+	ecsql::SerializedDatabase serialized = world.serialize();
+	sqlite3_int64 raw_size = serialized.size;
+	auto compress_start = std::chrono::steady_clock::now();
+	std::vector<uint8_t> snapshot_data = snapshot::compress(serialized);
+	std::chrono::duration<double, std::milli> compress_time = std::chrono::steady_clock::now() - compress_start;
+
+	auto load_start = std::chrono::steady_clock::now();
+	bool loaded_snapshot = world.restore_from(snapshot::decompress(snapshot_data));
+	std::chrono::duration<double, std::milli> load_time = std::chrono::steady_clock::now() - load_start;
+
+	std::cout << "snapshot: " << raw_size << " bytes raw, " << snapshot_data.size() << " bytes compressed" << std::endl;
+	std::cout << "  save_async: " << save_blocking_time.count() << " ms blocking the caller, " << save_total_time.count() << " ms until written" << (saved_snapshot ? "" : " (failed)") << std::endl;
+	std::cout << "  compress: " << compress_time.count() << " ms" << std::endl;
+	std::cout << "  load: " << load_time.count() << " ms" << (loaded_snapshot ? "" : " (failed)") << std::endl;
+
+	assetio::assetio_terminate();
+
+	if (frames_over_budget > 0) {
+		std::cerr << frames_over_budget << " frames allocated more than the budget of " << allocation_budget << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,120 @@
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <string_view>
+
+#include "../src/ecsql/executed_sql.hpp"
+#include "../src/ecsql/prepared_sql.hpp"
+#include "../src/ecsql/world.hpp"
+
+// Compares decoding rows through virtual SQLRow accessors with the statically dispatched SQLStatementRow,
+// on the shape of the DrawTexture query: 10 values, 5 of them optional
+struct BenchVector2 {
+	float x;
+	float y;
+};
+
+struct BenchColor {
+	unsigned char r;
+	unsigned char g;
+	unsigned char b;
+	unsigned char a;
+};
+
+#define BENCH_ROW_COLUMNS \
+	std::string_view, \
+	BenchVector2, \
+	std::optional<BenchVector2>, \
+	std::optional<BenchVector2>, \
+	float, \
+	std::optional<float>, \
+	std::optional<BenchVector2>, \
+	std::optional<BenchVector2>, \
+	BenchColor, \
+	float
+
+static const int ROW_COUNT = 100'000;
+static const int ITERATIONS = 20;
+
+static const char create_sql[] = R"(
+	CREATE TABLE bench_sprite(
+		path, x, y, previous_x, previous_y, pivot_x, pivot_y,
+		rotation, previous_rotation, width, height, scale_x, scale_y,
+		r, g, b, a, fixed_delta_progress
+	)
+)";
+
+// Every other row has NULL optionals, so both branches get exercised
+static const char populate_sql[] = R"(
+	WITH RECURSIVE ids(id) AS (
+		SELECT 1
+		UNION ALL
+		SELECT id + 1 FROM ids WHERE id < ?
+	)
+	INSERT INTO bench_sprite
+	SELECT
+		'sprite.png', id, id * 2,
+		iif(id % 2, id - 1, NULL), iif(id % 2, id * 2 - 1, NULL),
+		iif(id % 2, 0.5, NULL), iif(id % 2, 0.5, NULL),
+		id % 360, iif(id % 2, (id - 1) % 360, NULL),
+		iif(id % 2, 32, NULL), iif(id % 2, 32, NULL),
+		iif(id % 2, 1, NULL), iif(id % 2, 1, NULL),
+		255, 255, 255, 255, 0.5
+	FROM ids
+)";
+
+static const char select_sql[] = "SELECT * FROM bench_sprite";
+
+template<typename Row>
+static double accumulate(const Row& row) {
+	auto [path, position, previous_position, pivot, rotation, previous_rotation, size, scale, color, progress] = row.template get<BENCH_ROW_COLUMNS>();
+	double sum = path.size() + position.x + position.y + rotation + color.a + progress;
+	if (previous_position) sum += previous_position->x;
+	if (pivot) sum += pivot->y;
+	if (previous_rotation) sum += *previous_rotation;
+	if (size) sum += size->x;
+	if (scale) sum += scale->y;
+	return sum;
+}
+
+template<typename Fn>
+static double measure_ms(Fn&& f) {
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < ITERATIONS; i++) {
+		f();
+	}
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count() / ITERATIONS;
+}
+
+int main(int argc, const char **argv) {
+	ecsql::World world(":memory:", ":memory:");
+	world.execute_sql_script(create_sql);
+	world.inside_transaction([&]() {
+		world.execute_sql(populate_sql, ROW_COUNT);
+	});
+
+	ecsql::PreparedSQL select_rows = world.prepare_sql(select_sql, true);
+	select_rows.validate_columns<BENCH_ROW_COLUMNS>();
+
+	double virtual_sum = 0;
+	double virtual_ms = measure_ms([&]() {
+		for (ecsql::SQLRow row : select_rows()) {
+			virtual_sum += accumulate(row);
+		}
+	});
+
+	double static_sum = 0;
+	double static_ms = measure_ms([&]() {
+		for (auto it = select_rows().begin(); it; ++it) {
+			static_sum += accumulate(it.statement_row());
+		}
+	});
+
+	std::cout << ROW_COUNT << " rows" << std::endl
+		<< "  SQLRow:          " << virtual_ms << " ms" << std::endl
+		<< "  SQLStatementRow: " << static_ms << " ms" << std::endl
+		<< "  (checksums " << virtual_sum << " / " << static_sum << ")" << std::endl;
+	return 0;
+}
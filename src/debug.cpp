@@ -2,15 +2,69 @@
 
 #include "debug.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <future>
 #include <iostream>
+#include <string>
+#include <vector>
 
 #include <tracy/Tracy.hpp>
 #include <raylib.h>
 
+#include "memory.hpp"
 #include "ecsql/world.hpp"
 
 
 static bool paused = false;
+static bool show_profile = false;
+
+struct PendingBackup {
+	std::string path;
+	std::future<bool> result;
+};
+static std::vector<PendingBackup> pending_backups;
+
+static void report_finished_backups() {
+	std::erase_if(pending_backups, [](PendingBackup& backup) {
+		if (backup.result.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+			return false;
+		}
+		if (backup.result.get()) {
+			std::cout << "Backed up into \"" << backup.path << "\"" << std::endl;
+		}
+		return true;
+	});
+}
+
+static const int PROFILE_OVERLAY_MAX_SYSTEMS = 8;
+static const int PROFILE_OVERLAY_FONT_SIZE = 10;
+
+static void draw_profile_overlay(const ecsql::World& world) {
+	std::vector<const ecsql::SystemProfile *> profiles;
+	for (const ecsql::SystemProfile& profile : world.get_system_profiles()) {
+		profiles.push_back(&profile);
+	}
+	std::sort(profiles.begin(), profiles.end(), [](const ecsql::SystemProfile *a, const ecsql::SystemProfile *b) {
+		return a->time_ms > b->time_ms;
+	});
+
+	int y = 48;
+	const ecsql::PreparedSQLCache::Stats& sql_cache_stats = world.get_sql_cache_stats();
+	DrawText(TextFormat("sql cache: %llu hits / %llu misses / %llu evictions", sql_cache_stats.hits, sql_cache_stats.misses, sql_cache_stats.evictions), 0, y, PROFILE_OVERLAY_FONT_SIZE, LIME);
+	y += PROFILE_OVERLAY_FONT_SIZE + 2;
+	MemoryStats memory = get_memory_stats(world.get_db().get());
+	DrawText(TextFormat("pagecache: %d/%d slots, %d overflow bytes | lookaside: %d hits, %d misses | lua pool: %llu/%llu", memory.pagecache_used, memory.pagecache_slots, memory.pagecache_overflow_bytes, memory.lookaside_hits, memory.lookaside_misses_size + memory.lookaside_misses_full, memory.lua_pool_allocations, memory.lua_pool_allocations + memory.lua_fallback_allocations), 0, y, PROFILE_OVERLAY_FONT_SIZE, LIME);
+	y += PROFILE_OVERLAY_FONT_SIZE + 2;
+	DrawText("system: ms / vm steps / fullscan steps / sorts / autoindexes / culled", 0, y, PROFILE_OVERLAY_FONT_SIZE, LIME);
+	for (int i = 0; i < profiles.size() && i < PROFILE_OVERLAY_MAX_SYSTEMS; i++) {
+		const ecsql::SystemProfile& profile = *profiles[i];
+		const ecsql::StatementCounters& counters = profile.counters;
+		y += PROFILE_OVERLAY_FONT_SIZE + 2;
+		bool is_suspicious = counters.fullscan_steps > 0 || counters.autoindexes > 0;
+		DrawText(TextFormat("%s: %.3f / %d / %d / %d / %d / %d", profile.name.c_str(), profile.time_ms, counters.vm_steps, counters.fullscan_steps, counters.sorts, counters.autoindexes, profile.culled), 0, y, PROFILE_OVERLAY_FONT_SIZE, is_suspicious ? ORANGE : LIME);
+	}
+}
 
 bool is_paused() {
 	return paused;
@@ -20,18 +74,20 @@ void run_debug_functionality(ecsql::World& world) {
 	ZoneScoped;
 	DrawFPS(0, 0);
 
+	// Counted from one debug call to the next, so this includes the whole frame
+	static uint64_t last_allocation_count = get_allocation_count();
+	uint64_t allocation_count = get_allocation_count();
+	DrawText(TextFormat("%llu allocs/frame", (unsigned long long) (allocation_count - last_allocation_count)), 100, 0, 20, LIME);
+	last_allocation_count = allocation_count;
+
 	for (int fkey = KEY_F1; fkey <= KEY_F10; fkey++) {
 		bool is_shift_down = IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT);
 		if (IsKeyPressed(fkey)) {
 			const char *world_db_path = TextFormat("ecsql_world-backup%02d.sqlite3", fkey - KEY_F1 + 1);
 			const char *save_db_path = TextFormat("save-backup%02d.sqlite3", fkey - KEY_F1 + 1);
 			if (is_shift_down) {
-				if (world.backup_into(world_db_path)) {
-					std::cout << "World backed up into \"" << world_db_path << "\"" << std::endl;
-				}
-				if (world.backup_into(save_db_path, "save")) {
-					std::cout << "Save backed up into \"" << save_db_path << "\"" << std::endl;
-				}
+				pending_backups.push_back({ world_db_path, world.backup_into_async(world_db_path) });
+				pending_backups.push_back({ save_db_path, world.backup_into_async(save_db_path, "save") });
 			}
 			else {
 				if (world.restore_from(world_db_path)) {
@@ -43,6 +99,7 @@ void run_debug_functionality(ecsql::World& world) {
 			}
 		}
 	}
+	report_finished_backups();
 
 	if (IsKeyPressed(KEY_P)) {
 		paused = !paused;
@@ -51,6 +108,13 @@ void run_debug_functionality(ecsql::World& world) {
 	if (paused) {
 		DrawText("PAUSED", 0, 24, 20, LIME);
 	}
+
+	if (IsKeyPressed(KEY_F11)) {
+		show_profile = !show_profile;
+	}
+	if (show_profile) {
+		draw_profile_overlay(world);
+	}
 }
 
 
@@ -1,6 +1,8 @@
 #include <tracy/Tracy.hpp>
 
 #include "background_system.hpp"
+#include "read_connection_pool.hpp"
+#include "world.hpp"
 
 namespace ecsql {
 
@@ -11,10 +13,23 @@ BackgroundSystem::BackgroundSystem(std::string_view name, std::function<void()>
 {
 }
 
-void BackgroundSystem::operator()() {
+BackgroundSystem::BackgroundSystem(std::string_view name, std::function<void(ReadConnection&)> implementation, bool join_before_new_frame)
+	: name(name)
+	, read_implementation(implementation)
+	, join_before_new_frame(join_before_new_frame)
+{
+}
+
+void BackgroundSystem::operator()(World& world) {
 	ZoneScoped;
 	ZoneName(name.c_str(), name.size());
-	implementation();
+	if (read_implementation) {
+		ReadConnection connection = world.acquire_read_connection();
+		read_implementation(connection);
+	}
+	else {
+		implementation();
+	}
 }
 
 const std::string& BackgroundSystem::get_name() const {
@@ -25,4 +40,8 @@ bool BackgroundSystem::should_join_before_new_frame() const {
 	return join_before_new_frame;
 }
 
+bool BackgroundSystem::uses_read_connection() const {
+	return (bool) read_implementation;
+}
+
 }
@@ -4,18 +4,27 @@
 
 namespace ecsql {
 
+class ReadConnection;
+class World;
+
 class BackgroundSystem {
 public:
 	BackgroundSystem(std::string_view name, std::function<void()> implementation, bool join_before_new_frame = true);
+	// Background system that reads world state from a read-only connection, seeing the frame committed right before it was dispatched.
+	// Databases without WAL, like in-memory ones, cannot commit while being read,
+	// so these are always joined before the next commit there, even when `join_before_new_frame` is false.
+	BackgroundSystem(std::string_view name, std::function<void(ReadConnection&)> implementation, bool join_before_new_frame = true);
 
-	void operator()();
+	void operator()(World& world);
 
 	const std::string& get_name() const;
 	bool should_join_before_new_frame() const;
+	bool uses_read_connection() const;
 
 private:
 	std::string name;
 	std::function<void()> implementation;
+	std::function<void(ReadConnection&)> read_implementation;
 	bool join_before_new_frame;
 };
 
@@ -0,0 +1,9 @@
+#include "batched_hook_system.hpp"
+
+namespace ecsql {
+
+void BatchedHookSystem::operator()(std::span<const HookChange> changes) const {
+	implementation(changes);
+}
+
+}
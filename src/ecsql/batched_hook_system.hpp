@@ -0,0 +1,54 @@
+#pragma once
+
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "component.hpp"
+#include "hook_system.hpp"
+#include "sql_value_row.hpp"
+#include "static_linked_list.hpp"
+
+namespace ecsql {
+
+// Row change buffered for a BatchedHookSystem.
+// `old_row` is empty for inserts and `new_row` is empty for deletes.
+struct HookChange {
+	HookType hook;
+	SQLValueRow old_row;
+	SQLValueRow new_row;
+};
+
+// Hook system that receives changes to its component table in batches, in the order they happened.
+// Batches are delivered by the World before and after each system runs and before committing transactions,
+// instead of once per row from inside SQLite's preupdate hook.
+// Main thread only hooks, e.g. the ones that load GPU resources, are held back while frames are simulated
+// in a worker thread and delivered when `World::update` returns.
+class BatchedHookSystem {
+public:
+	template<typename Fn>
+	BatchedHookSystem(std::string_view component_name, Fn&& implementation, bool is_main_thread_only = false)
+		: component_name(component_name)
+		, implementation([=](std::span<const HookChange> changes) { implementation(changes); })
+		, is_main_thread_only(is_main_thread_only)
+	{
+		STATIC_LINKED_LIST_INSERT();
+	}
+
+	template<typename Fn>
+	BatchedHookSystem(const Component& component, Fn&& implementation, bool is_main_thread_only = false)
+		: BatchedHookSystem(component.get_name(), implementation, is_main_thread_only)
+	{
+	}
+
+	void operator()(std::span<const HookChange> changes) const;
+
+	std::string component_name;
+	std::function<void(std::span<const HookChange>)> implementation;
+	bool is_main_thread_only;
+
+	STATIC_LINKED_LIST_DEFINE(BatchedHookSystem);
+};
+
+}
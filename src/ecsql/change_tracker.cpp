@@ -0,0 +1,368 @@
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <string>
+
+#include <sqlite3.h>
+#include <tracy/Tracy.hpp>
+
+#include "change_tracker.hpp"
+
+namespace ecsql {
+
+// Iterator
+ChangeTracker::TableChanges::iterator::iterator(const TableChanges *changes, size_t index)
+	: changes(changes)
+	, index(index)
+{
+	skip_stale();
+}
+
+const ChangedEntity& ChangeTracker::TableChanges::iterator::operator*() const {
+	return changes->log[index];
+}
+
+const ChangedEntity *ChangeTracker::TableChanges::iterator::operator->() const {
+	return &changes->log[index];
+}
+
+ChangeTracker::TableChanges::iterator& ChangeTracker::TableChanges::iterator::operator++() {
+	index++;
+	skip_stale();
+	return *this;
+}
+
+bool ChangeTracker::TableChanges::iterator::operator==(const iterator& other) const {
+	return index == other.index;
+}
+
+bool ChangeTracker::TableChanges::iterator::operator!=(const iterator& other) const {
+	return index != other.index;
+}
+
+void ChangeTracker::TableChanges::iterator::skip_stale() {
+	while (index < changes->log.size() && !changes->is_current(index)) {
+		index++;
+	}
+}
+
+// TableChanges
+void ChangeTracker::TableChanges::record(EntityID entity_id, uint64_t frame, bool removed) {
+	std::lock_guard lock(mutex);
+	auto [it, inserted] = latest.emplace(entity_id, log.size());
+	if (inserted) {
+		undo_log.push_back({ entity_id, NO_INDEX, false, false });
+	}
+	else {
+		ChangedEntity& last_change = log[it->second];
+		if (last_change.frame == frame) {
+			undo_log.push_back({ entity_id, it->second, true, last_change.removed });
+			last_change.removed = removed;
+			return;
+		}
+		undo_log.push_back({ entity_id, it->second, false, false });
+		it->second = log.size();
+	}
+	log.push_back({ entity_id, frame, removed });
+}
+
+ChangeTracker::TableChanges::Range ChangeTracker::TableChanges::since(uint64_t frame) const {
+	auto first = std::upper_bound(log.begin(), log.end(), frame, [](uint64_t frame, const ChangedEntity& change) {
+		return frame < change.frame;
+	});
+	return {
+		iterator(this, first - log.begin()),
+		iterator(this, log.size()),
+	};
+}
+
+ChangeTracker::TableChanges::Range ChangeTracker::TableChanges::all() const {
+	return {
+		iterator(this, 0),
+		iterator(this, log.size()),
+	};
+}
+
+void ChangeTracker::TableChanges::compact(uint64_t current_frame, uint64_t removed_retention_frames) {
+	// Only rewrite the log once stale entries dominate it
+	if (log.size() < 2 * latest.size() + 64) {
+		return;
+	}
+	ZoneScoped;
+	std::lock_guard lock(mutex);
+	std::vector<ChangedEntity> compacted;
+	compacted.reserve(latest.size());
+	for (size_t i = 0; i < log.size(); i++) {
+		if (!is_current(i)) {
+			continue;
+		}
+		const ChangedEntity& change = log[i];
+		if (change.removed && change.frame + removed_retention_frames < current_frame) {
+			latest.erase(change.entity_id);
+			continue;
+		}
+		latest[change.entity_id] = compacted.size();
+		compacted.push_back(change);
+	}
+	log = std::move(compacted);
+	committed_size = log.size();
+}
+
+void ChangeTracker::TableChanges::commit() {
+	std::lock_guard lock(mutex);
+	undo_log.clear();
+	committed_size = log.size();
+}
+
+void ChangeTracker::TableChanges::rollback() {
+	std::lock_guard lock(mutex);
+	for (auto it = undo_log.rbegin(); it != undo_log.rend(); ++it) {
+		const Undo& undo = *it;
+		if (undo.previous_index == NO_INDEX) {
+			latest.erase(undo.entity_id);
+		}
+		else if (undo.overwritten) {
+			log[undo.previous_index].removed = undo.previous_removed;
+		}
+		else {
+			latest[undo.entity_id] = undo.previous_index;
+		}
+	}
+	undo_log.clear();
+	log.resize(committed_size);
+}
+
+std::unique_lock<std::mutex> ChangeTracker::TableChanges::lock() const {
+	return std::unique_lock(mutex);
+}
+
+bool ChangeTracker::TableChanges::is_current(size_t index) const {
+	auto it = latest.find(log[index].entity_id);
+	return it != latest.end() && it->second == index;
+}
+
+// ChangeTracker
+ChangeTracker::ChangeTracker(uint64_t removed_retention_frames)
+	: removed_retention_frames(removed_retention_frames)
+{
+}
+
+ChangeTracker::TableChanges& ChangeTracker::track(std::string_view table) {
+	std::lock_guard lock(tables_mutex);
+	return tables[std::string(table)];
+}
+
+const ChangeTracker::TableChanges *ChangeTracker::find(std::string_view table) const {
+	std::lock_guard lock(tables_mutex);
+	auto it = tables.find(std::string(table));
+	return it != tables.end() ? &it->second : nullptr;
+}
+
+void ChangeTracker::compact(uint64_t current_frame) {
+	for (auto& [table, changes] : tables) {
+		changes.compact(current_frame, removed_retention_frames);
+	}
+}
+
+void ChangeTracker::commit() {
+	for (auto& [table, changes] : tables) {
+		changes.commit();
+	}
+}
+
+void ChangeTracker::rollback() {
+	for (auto& [table, changes] : tables) {
+		changes.rollback();
+	}
+}
+
+// Changed(component, since) table-valued function
+enum ChangedColumn {
+	COLUMN_ENTITY_ID,
+	COLUMN_FRAME,
+	COLUMN_REMOVED,
+	COLUMN_COMPONENT,
+	COLUMN_SINCE,
+};
+
+struct changed_vtab : public sqlite3_vtab {
+	ChangeTracker *tracker;
+};
+
+struct changed_cursor : public sqlite3_vtab_cursor {
+	std::vector<ChangedEntity> changes;
+	size_t index;
+	std::string component;
+	std::optional<sqlite3_int64> since;
+};
+
+static int changed_connect(sqlite3 *db, void *aux, int argc, const char *const *argv, sqlite3_vtab **out_vtab, char **out_error) {
+	int res = sqlite3_declare_vtab(db, "CREATE TABLE x(entity_id, frame, removed, component HIDDEN, since HIDDEN)");
+	if (res != SQLITE_OK) {
+		return res;
+	}
+	changed_vtab *vtab = (changed_vtab *) sqlite3_malloc(sizeof(changed_vtab));
+	if (!vtab) {
+		return SQLITE_NOMEM;
+	}
+	memset(vtab, 0, sizeof(changed_vtab));
+	vtab->tracker = (ChangeTracker *) aux;
+	*out_vtab = vtab;
+	return SQLITE_OK;
+}
+
+static int changed_disconnect(sqlite3_vtab *vtab) {
+	sqlite3_free(vtab);
+	return SQLITE_OK;
+}
+
+// idxNum bit 1: has component constraint, bit 2: has since constraint
+static int changed_best_index(sqlite3_vtab *vtab, sqlite3_index_info *index_info) {
+	int component_constraint = -1;
+	int since_constraint = -1;
+	for (int i = 0; i < index_info->nConstraint; i++) {
+		const auto& constraint = index_info->aConstraint[i];
+		if (constraint.op != SQLITE_INDEX_CONSTRAINT_EQ) {
+			continue;
+		}
+		if (!constraint.usable) {
+			// SQLite cannot filter on hidden columns by itself, so plans without them are rejected
+			if (constraint.iColumn == COLUMN_COMPONENT || constraint.iColumn == COLUMN_SINCE) {
+				return SQLITE_CONSTRAINT;
+			}
+			continue;
+		}
+		if (constraint.iColumn == COLUMN_COMPONENT) {
+			component_constraint = i;
+		}
+		else if (constraint.iColumn == COLUMN_SINCE) {
+			since_constraint = i;
+		}
+	}
+	if (component_constraint < 0) {
+		sqlite3_free(vtab->zErrMsg);
+		vtab->zErrMsg = sqlite3_mprintf("Changed() requires a component name");
+		return SQLITE_ERROR;
+	}
+	index_info->idxNum = 1;
+	index_info->aConstraintUsage[component_constraint].argvIndex = 1;
+	index_info->aConstraintUsage[component_constraint].omit = 1;
+	if (since_constraint >= 0) {
+		index_info->idxNum |= 2;
+		index_info->aConstraintUsage[since_constraint].argvIndex = 2;
+		index_info->aConstraintUsage[since_constraint].omit = 1;
+		index_info->estimatedCost = 10;
+	}
+	else {
+		index_info->estimatedCost = 1000;
+	}
+	return SQLITE_OK;
+}
+
+static int changed_open(sqlite3_vtab *vtab, sqlite3_vtab_cursor **out_cursor) {
+	*out_cursor = new changed_cursor();
+	return SQLITE_OK;
+}
+
+static int changed_close(sqlite3_vtab_cursor *cursor) {
+	delete (changed_cursor *) cursor;
+	return SQLITE_OK;
+}
+
+static int changed_filter(sqlite3_vtab_cursor *base_cursor, int index_num, const char *index_str, int argc, sqlite3_value **argv) {
+	changed_cursor *cursor = (changed_cursor *) base_cursor;
+	ChangeTracker *tracker = ((changed_vtab *) base_cursor->pVtab)->tracker;
+	cursor->changes.clear();
+	cursor->index = 0;
+
+	const char *component = (const char *) sqlite3_value_text(argv[0]);
+	sqlite3_int64 since = (index_num & 2) ? sqlite3_value_int64(argv[1]) : -1;
+	cursor->component = component ? component : "";
+	if (index_num & 2) {
+		cursor->since = since;
+	}
+	else {
+		cursor->since.reset();
+	}
+	const ChangeTracker::TableChanges *changes = component ? tracker->find(component) : nullptr;
+	if (!changes) {
+		sqlite3_free(base_cursor->pVtab->zErrMsg);
+		base_cursor->pVtab->zErrMsg = sqlite3_mprintf("Changes are not tracked for component '%s', call World::track_changes first", component);
+		return SQLITE_ERROR;
+	}
+	// Copy results, so that statements may change the tracked table while reading from it
+	auto lock = changes->lock();
+	for (const ChangedEntity& change : since >= 0 ? changes->since(since) : changes->all()) {
+		cursor->changes.push_back(change);
+	}
+	return SQLITE_OK;
+}
+
+static int changed_next(sqlite3_vtab_cursor *cursor) {
+	((changed_cursor *) cursor)->index++;
+	return SQLITE_OK;
+}
+
+static int changed_eof(sqlite3_vtab_cursor *base_cursor) {
+	changed_cursor *cursor = (changed_cursor *) base_cursor;
+	return cursor->index >= cursor->changes.size();
+}
+
+static int changed_column(sqlite3_vtab_cursor *base_cursor, sqlite3_context *ctx, int column) {
+	changed_cursor *cursor = (changed_cursor *) base_cursor;
+	const ChangedEntity& change = cursor->changes[cursor->index];
+	switch (column) {
+		case COLUMN_ENTITY_ID:
+			sqlite3_result_int64(ctx, change.entity_id);
+			break;
+
+		case COLUMN_FRAME:
+			sqlite3_result_int64(ctx, change.frame);
+			break;
+
+		case COLUMN_REMOVED:
+			sqlite3_result_int(ctx, change.removed);
+			break;
+
+		case COLUMN_COMPONENT:
+			sqlite3_result_text(ctx, cursor->component.c_str(), cursor->component.size(), SQLITE_TRANSIENT);
+			break;
+
+		case COLUMN_SINCE:
+			if (cursor->since) {
+				sqlite3_result_int64(ctx, *cursor->since);
+			}
+			else {
+				sqlite3_result_null(ctx);
+			}
+			break;
+	}
+	return SQLITE_OK;
+}
+
+static int changed_rowid(sqlite3_vtab_cursor *base_cursor, sqlite3_int64 *out_rowid) {
+	*out_rowid = ((changed_cursor *) base_cursor)->index;
+	return SQLITE_OK;
+}
+
+static sqlite3_module changed_module = {
+	0,                   // iVersion
+	nullptr,             // xCreate: eponymous-only
+	changed_connect,     // xConnect
+	changed_best_index,  // xBestIndex
+	changed_disconnect,  // xDisconnect
+	nullptr,             // xDestroy
+	changed_open,        // xOpen
+	changed_close,       // xClose
+	changed_filter,      // xFilter
+	changed_next,        // xNext
+	changed_eof,         // xEof
+	changed_column,      // xColumn
+	changed_rowid,       // xRowid
+};
+
+void ChangeTracker::register_sql_function(sqlite3 *db) {
+	sqlite3_create_module(db, "Changed", &changed_module, this);
+}
+
+}
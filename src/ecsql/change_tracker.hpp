@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "entity.hpp"
+
+typedef struct sqlite3 sqlite3;
+
+namespace ecsql {
+
+struct ChangedEntity {
+	EntityID entity_id;
+	// Frame of the last change
+	uint64_t frame;
+	// Whether the component was removed from the entity in the last change
+	bool removed;
+};
+
+// Frame-stamped dirty tracking for component tables, fed by the World's preupdate hook.
+// Only the last change of each entity is kept, so memory is proportional to the number of entities in each table,
+// plus removals from the last `removed_retention_frames` frames.
+// Read connections may query `Changed` too, so recording and reading are synchronized.
+// They see changes from the frame being simulated, even before it is committed.
+class ChangeTracker {
+public:
+	class TableChanges {
+	public:
+		// Iterates over entities whose last change happened after some frame, in order of change
+		class iterator {
+		public:
+			using value_type = ChangedEntity;
+
+			iterator(const TableChanges *changes, size_t index);
+
+			const ChangedEntity& operator*() const;
+			const ChangedEntity *operator->() const;
+			iterator& operator++();
+			bool operator==(const iterator& other) const;
+			bool operator!=(const iterator& other) const;
+
+		private:
+			const TableChanges *changes;
+			size_t index;
+
+			void skip_stale();
+		};
+
+		struct Range {
+			iterator first;
+			iterator last;
+
+			iterator begin() const { return first; }
+			iterator end() const { return last; }
+		};
+
+		void record(EntityID entity_id, uint64_t frame, bool removed);
+		// Changes that happened strictly after `frame`
+		Range since(uint64_t frame) const;
+		Range all() const;
+		// Only call between transactions, for it invalidates the undo log
+		void compact(uint64_t current_frame, uint64_t removed_retention_frames);
+		// Keep or forget changes recorded since the last commit, following the world's transaction
+		void commit();
+		void rollback();
+		// Hold while iterating changes from other threads, e.g. from read connections
+		std::unique_lock<std::mutex> lock() const;
+
+	private:
+		struct Undo {
+			EntityID entity_id;
+			// Index in `latest` before the change, or `NO_INDEX` if the entity had no changes
+			size_t previous_index;
+			// Changes in the same frame overwrite the last entry instead of appending a new one
+			bool overwritten;
+			bool previous_removed;
+		};
+		static constexpr size_t NO_INDEX = SIZE_MAX;
+
+		// Sorted by frame. Entries superseded by a newer change to the same entity are stale.
+		std::vector<ChangedEntity> log;
+		std::unordered_map<EntityID, size_t> latest;
+		std::vector<Undo> undo_log;
+		size_t committed_size = 0;
+		mutable std::mutex mutex;
+
+		bool is_current(size_t index) const;
+	};
+
+	ChangeTracker(uint64_t removed_retention_frames = DEFAULT_REMOVED_RETENTION_FRAMES);
+
+	TableChanges& track(std::string_view table);
+	const TableChanges *find(std::string_view table) const;
+
+	void compact(uint64_t current_frame);
+	void commit();
+	void rollback();
+
+	// Registers the `Changed(component, since)` table-valued function, with columns `entity_id, frame, removed`.
+	// A negative or missing `since` returns all changes.
+	void register_sql_function(sqlite3 *db);
+
+	static constexpr uint64_t DEFAULT_REMOVED_RETENTION_FRAMES = 600;
+
+private:
+	std::unordered_map<std::string, TableChanges> tables;
+	mutable std::mutex tables_mutex;
+	uint64_t removed_retention_frames;
+};
+
+}
@@ -1,11 +1,28 @@
+#include <algorithm>
+#include <bit>
+#include <format>
+#include <stdexcept>
+
 #include <sqlite3.h>
 
 #include "component.hpp"
 #include "sql_utility.hpp"
 #include "static_linked_list.hpp"
+#include "world.hpp"
 
 namespace ecsql {
 
+// Appends "(?, ?), (?, ?)..." for `row_count` rows of `column_count` columns
+static void append_values_rows(std::string& query, int row_count, int column_count) {
+	for (int row = 0; row < row_count; row++) {
+		query += row > 0 ? ", (?" : "(?";
+		for (int column = 1; column < column_count; column++) {
+			query += ", ?";
+		}
+		query += ")";
+	}
+}
+
 Component::Component(std::string_view name, const std::vector<std::string>& fields, std::string_view additional_schema, bool allow_duplicate)
 	: name(name)
 	, fields(fields)
@@ -37,8 +54,22 @@ int Component::first_field_index() const {
 }
 
 std::string Component::schema_sql() const {
+	std::string query = table_schema_sql("");
+	if (!additional_schema.empty()) {
+		query += "\n";
+		query += additional_schema;
+	}
+	return query;
+}
+
+std::string Component::prefab_schema_sql() const {
+	return table_schema_sql("prefab.");
+}
+
+std::string Component::table_schema_sql(std::string_view schema_name) const {
 	std::string query;
 	query = "CREATE TABLE ";
+	query += schema_name;
 	query += name;
 	if (allow_duplicate) {
 		query += "(\n  id INTEGER PRIMARY KEY,\n  entity_id INTEGER NOT NULL REFERENCES entity(id) ON DELETE CASCADE";
@@ -53,15 +84,12 @@ std::string Component::schema_sql() const {
 	query += "\n);";
 	if (allow_duplicate) {
 		query += "\nCREATE INDEX ";
+		query += schema_name;
 		query += name;
 		query += "_entity_id ON ";
 		query += name;
 		query += "(entity_id);";
 	}
-	if (!additional_schema.empty()) {
-		query += "\n";
-		query += additional_schema;
-	}
 	return query;
 }
 
@@ -103,6 +131,118 @@ std::string Component::update_sql() const {
 	return query;
 }
 
+std::string Component::insert_many_sql(int row_count, bool or_replace) const {
+	std::string query;
+	query = "INSERT ";
+	if (or_replace) {
+		query += "OR REPLACE ";
+	}
+	query += "INTO ";
+	query += name;
+	query += "(entity_id";
+	for (auto& it : fields) {
+		query += ", ";
+		query += extract_identifier(it);
+	}
+	query += ") VALUES";
+	append_values_rows(query, row_count, fields.size() + 1);
+	return query;
+}
+
+std::string Component::upsert_many_sql(int row_count) const {
+	if (allow_duplicate) {
+		throw std::runtime_error(std::format("Cannot upsert into component '{}', which allows duplicates", name));
+	}
+	std::string query = insert_many_sql(row_count);
+	query += " ON CONFLICT DO UPDATE SET ";
+	for (int i = 0; i < fields.size(); i++) {
+		if (i > 0) {
+			query += ", ";
+		}
+		std::string_view field = extract_identifier(fields[i]);
+		query += field;
+		query += " = excluded.";
+		query += field;
+	}
+	return query;
+}
+
+std::string Component::update_many_sql(int row_count) const {
+	std::string query;
+	query = "UPDATE ";
+	query += name;
+	query += " SET ";
+	for (int i = 0; i < fields.size(); i++) {
+		if (i > 0) {
+			query += ", ";
+		}
+		query += extract_identifier(fields[i]);
+		query += " = batch.column";
+		query += std::to_string(i + 2);
+	}
+	query += " FROM (VALUES";
+	append_values_rows(query, row_count, fields.size() + 1);
+	query += ") AS batch WHERE ";
+	query += name;
+	// duplicates share the same entity_id, so only `id` identifies a single row
+	query += allow_duplicate ? ".id = batch.column1" : ".entity_id = batch.column1";
+	return query;
+}
+
+std::string Component::instantiate_sql() const {
+	std::string query;
+	query = "INSERT INTO main.";
+	query += name;
+	query += "(entity_id";
+	for (auto& it : fields) {
+		query += ", ";
+		query += extract_identifier(it);
+	}
+	query += ")\nSELECT prefab_instance.entity_id";
+	for (auto& it : fields) {
+		std::string_view field = extract_identifier(it);
+		std::string path = std::format("prefab_instance.path || '.{}.{}'", name, field);
+		query += std::format(",\n  iif(prefab_instance.is_root AND json_type(?1, {0}) IS NOT NULL, json_extract(?1, {0}), prefab_row.{1})", path, field);
+	}
+	query += "\nFROM temp.prefab_instance JOIN prefab.";
+	query += name;
+	query += " AS prefab_row ON prefab_row.entity_id = prefab_instance.prefab_entity_id";
+	return query;
+}
+
+int Component::max_batch_rows(World& world) const {
+	int columns_per_row = fields.size() + 1;
+	int variable_limit = sqlite3_limit(world.get_db().get(), SQLITE_LIMIT_VARIABLE_NUMBER, -1);
+	return std::bit_floor((unsigned) std::clamp(variable_limit / columns_per_row, 1, MAX_ROWS_PER_STATEMENT));
+}
+
+PreparedSQL Component::batch_sql(World& world, BatchKind kind, int row_count) const {
+	if (batch_sql_texts.empty()) {
+		batch_sql_texts.resize(BATCH_KIND_COUNT * BATCH_SIZE_COUNT);
+	}
+	std::string& sql = batch_sql_texts[(int) kind * BATCH_SIZE_COUNT + std::countr_zero((unsigned) row_count)];
+	if (sql.empty()) {
+		switch (kind) {
+			case BatchKind::Insert:
+				sql = insert_many_sql(row_count);
+				break;
+
+			case BatchKind::InsertOrReplace:
+				sql = insert_many_sql(row_count, true);
+				break;
+
+			case BatchKind::Upsert:
+				sql = upsert_many_sql(row_count);
+				break;
+
+			case BatchKind::Update:
+				sql = update_many_sql(row_count);
+				break;
+		}
+	}
+	return world.cached_sql(sql);
+}
+
 const std::string& Component::get_name() const {
 	return name;
 }
@@ -1,18 +1,23 @@
 #pragma once
 
+#include <algorithm>
+#include <bit>
+#include <span>
 #include <string>
 #include <string_view>
 #include <vector>
 
 #include <reflect>
+#include <sqlite3.h>
 
 #include "entity.hpp"
+#include "prepared_sql.hpp"
 #include "static_linked_list.hpp"
 
-typedef struct sqlite3 sqlite3;
-
 namespace ecsql {
 
+class World;
+
 class Component {
 public:
 	Component(std::string_view name, const std::vector<std::string>& fields, std::string_view additional_schema = "", bool allow_duplicate = false);
@@ -26,17 +31,84 @@ public:
 	int first_field_index() const;
 
 	std::string schema_sql() const;
+	// Same table in the `prefab` database, without the additional schema
+	std::string prefab_schema_sql() const;
 	std::string insert_sql(bool or_replace = false) const;
 	std::string update_sql() const;
+	// Multi-row versions of `insert_sql` and `update_sql`, binding the row key followed by all fields for each row.
+	// The key is `entity_id`, except for updates of components that allow duplicates, which match rows by `id`.
+	std::string insert_many_sql(int row_count, bool or_replace = false) const;
+	// Inserts rows, updating the fields of entities that already have the component. Not available with `allow_duplicate`.
+	std::string upsert_many_sql(int row_count) const;
+	std::string update_many_sql(int row_count) const;
+	// Copies rows from `prefab` into the entities mapped in `temp.prefab_instance`.
+	// Root fields present in the JSON bound to ?1 at `<instance path>.<component>.<field>` override prefab values.
+	std::string instantiate_sql() const;
+
+	// Insert, upsert or update all rows in as few statements as the bound variable limit allows,
+	// using statements from the world's cache.
+	// `T` must flatten into the row key followed by the component fields, in order, like in `insert_many_sql`.
+	// Returns the number of changed rows.
+	template<typename T>
+	int insert_many(World& world, std::span<const T> rows, bool or_replace = false) const {
+		return execute_many(world, rows, or_replace ? BatchKind::InsertOrReplace : BatchKind::Insert);
+	}
+	template<typename T>
+	int upsert_many(World& world, std::span<const T> rows) const {
+		return execute_many(world, rows, BatchKind::Upsert);
+	}
+	template<typename T>
+	int update_many(World& world, std::span<const T> rows) const {
+		return execute_many(world, rows, BatchKind::Update);
+	}
 
 	const std::string& get_name() const;
 	const std::vector<std::string>& get_fields() const;
 
 protected:
+	// Keep statements at a reasonable size, even if the variable limit is huge
+	static constexpr int MAX_ROWS_PER_STATEMENT = 256;
+	// Batches have power of two row counts, so there are few distinct statements per component
+	static constexpr int BATCH_SIZE_COUNT = std::countr_zero((unsigned) MAX_ROWS_PER_STATEMENT) + 1;
+
+	enum class BatchKind {
+		Insert,
+		InsertOrReplace,
+		Upsert,
+		Update,
+	};
+	static constexpr int BATCH_KIND_COUNT = 4;
+
 	std::string name;
 	std::vector<std::string> fields;
 	std::string additional_schema;
 	bool allow_duplicate;
+	// SQL text of batch statements, by kind and batch size
+	mutable std::vector<std::string> batch_sql_texts;
+
+	std::string table_schema_sql(std::string_view schema_name) const;
+	// Biggest power of two row count that fits the world's bound variable limit
+	int max_batch_rows(World& world) const;
+	PreparedSQL batch_sql(World& world, BatchKind kind, int row_count) const;
+
+	template<typename T>
+	int execute_many(World& world, std::span<const T> rows, BatchKind kind) const {
+		int columns_per_row = fields.size() + 1;
+		int max_rows = max_batch_rows(world);
+		int changes = 0;
+		while (!rows.empty()) {
+			int row_count = std::bit_floor(std::min<size_t>(rows.size(), max_rows));
+			PreparedSQL batch_stmt = batch_sql(world, kind, row_count);
+			batch_stmt.reset();
+			for (int i = 0; i < row_count; i++) {
+				batch_stmt.bind(1 + i * columns_per_row, rows[i]);
+			}
+			batch_stmt.execute();
+			changes += sqlite3_changes(sqlite3_db_handle(batch_stmt.get_stmt().get()));
+			rows = rows.subspan(row_count);
+		}
+		return changes;
+	}
 
 	STATIC_LINKED_LIST_DEFINE(Component);
 };
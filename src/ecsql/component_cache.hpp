@@ -0,0 +1,178 @@
+#pragma once
+
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <reflect>
+#include <sqlite3.h>
+
+#include "entity.hpp"
+#include "hook_system.hpp"
+#include "prepared_sql.hpp"
+#include "sql_base_row.hpp"
+#include "sql_row.hpp"
+
+namespace ecsql {
+
+// Struct-of-arrays copy of a component table, kept in sync by a HookSystem.
+// Each top-level field of `T` maps to one contiguous array, in the same order as the component columns.
+// SQL remains the source of truth: rows are mirrored as they are written, and the cache is reloaded when the World rolls back.
+// Only components without duplicates are supported, that is, with `entity_id` as the table's primary key.
+// The hook system points back to the cache, so caches cannot be copied or moved and must outlive the World.
+template<typename T>
+class ComponentCache {
+public:
+	static constexpr size_t field_count = reflect::size<T>();
+
+	template<size_t I>
+	using field_type = std::remove_cvref_t<decltype(reflect::get<I>(std::declval<T&>()))>;
+
+	ComponentCache(std::string_view component_name = reflect::type_name<T>())
+		: component_name(component_name)
+	{
+		hook_system.on_rollback = [this](sqlite3 *db) {
+			reload(db);
+		};
+	}
+	ComponentCache(const ComponentCache&) = delete;
+	ComponentCache(ComponentCache&&) = delete;
+	ComponentCache& operator=(const ComponentCache&) = delete;
+	ComponentCache& operator=(ComponentCache&&) = delete;
+
+	size_t size() const {
+		return entity_ids.size();
+	}
+
+	bool empty() const {
+		return entity_ids.empty();
+	}
+
+	bool contains(EntityID entity_id) const {
+		return index_by_entity.contains(entity_id);
+	}
+
+	std::optional<size_t> index_of(EntityID entity_id) const {
+		auto it = index_by_entity.find(entity_id);
+		if (it != index_by_entity.end()) {
+			return it->second;
+		}
+		else {
+			return std::nullopt;
+		}
+	}
+
+	std::span<const EntityID> entities() const {
+		return entity_ids;
+	}
+
+	template<size_t I>
+	std::span<const field_type<I>> field() const {
+		return std::get<I>(fields);
+	}
+
+	T get(size_t index) const {
+		T value;
+		reflect::for_each<T>([&](auto I) {
+			reflect::get<I>(value) = std::get<I>(fields)[index];
+		});
+		return value;
+	}
+
+	void clear() {
+		entity_ids.clear();
+		index_by_entity.clear();
+		std::apply([](auto&... field) { (field.clear(), ...); }, fields);
+	}
+
+	// Rebuild the cache from the component table
+	void reload(sqlite3 *db) {
+		clear();
+		std::string sql = "SELECT * FROM ";
+		sql += component_name;
+		PreparedSQL select_all(db, sql, false);
+		for (SQLRow row : select_all()) {
+			upsert(row.get<EntityID>(0), row.get<T>(1));
+		}
+	}
+
+	const std::string& get_name() const {
+		return component_name;
+	}
+
+private:
+	std::string component_name;
+	std::vector<EntityID> entity_ids;
+	decltype([]<size_t... I>(std::index_sequence<I...>) {
+		return std::tuple<std::vector<field_type<I>>...>();
+	}(std::make_index_sequence<field_count>())) fields;
+	std::unordered_map<EntityID, size_t> index_by_entity;
+
+	void upsert(EntityID entity_id, const T& value) {
+		auto [it, inserted] = index_by_entity.emplace(entity_id, entity_ids.size());
+		if (inserted) {
+			entity_ids.push_back(entity_id);
+			reflect::for_each<T>([&](auto I) {
+				std::get<I>(fields).push_back(reflect::get<I>(value));
+			});
+		}
+		else {
+			reflect::for_each<T>([&](auto I) {
+				std::get<I>(fields)[it->second] = reflect::get<I>(value);
+			});
+		}
+	}
+
+	// Swap with the last element, so that arrays stay contiguous
+	void remove(EntityID entity_id) {
+		auto it = index_by_entity.find(entity_id);
+		if (it == index_by_entity.end()) {
+			return;
+		}
+		size_t index = it->second;
+		size_t last_index = entity_ids.size() - 1;
+		index_by_entity.erase(it);
+		if (index != last_index) {
+			EntityID last_entity_id = entity_ids[last_index];
+			entity_ids[index] = last_entity_id;
+			std::apply([&](auto&... field) { ((field[index] = std::move(field[last_index])), ...); }, fields);
+			index_by_entity[last_entity_id] = index;
+		}
+		entity_ids.pop_back();
+		std::apply([](auto&... field) { (field.pop_back(), ...); }, fields);
+	}
+
+public:
+	HookSystem hook_system {
+		HookSystem::Unlisted{},
+		component_name,
+		[this](HookType hook, SQLBaseRow& old_row, SQLBaseRow& new_row) {
+			switch (hook) {
+				case HookType::OnInsert:
+					upsert(new_row.get<EntityID>(0), new_row.get<T>(1));
+					break;
+
+				case HookType::OnUpdate: {
+					EntityID old_entity_id = old_row.get<EntityID>(0);
+					EntityID new_entity_id = new_row.get<EntityID>(0);
+					if (old_entity_id != new_entity_id) {
+						remove(old_entity_id);
+					}
+					upsert(new_entity_id, new_row.get<T>(1));
+					break;
+				}
+
+				case HookType::OnDelete:
+					remove(old_row.get<EntityID>(0));
+					break;
+			}
+		}
+	};
+};
+
+}
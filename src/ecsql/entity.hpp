@@ -17,6 +17,11 @@ struct Entity {
 	inline static const char delete_sql[] = "DELETE FROM entity WHERE id = ?";
 	inline static const char delete_by_name_sql[] = "DELETE FROM entity WHERE name = ?";
 	inline static const char find_by_name_sql[] = "SELECT id FROM entity WHERE name = ?";
+	// Hierarchy queries over `entity_closure`, returning `(id, depth)` rows, nearest first.
+	// ?2 is the minimum depth: 0 includes the entity itself, 1 skips it.
+	inline static const char select_descendants_sql[] = "SELECT descendant_id, depth FROM entity_closure WHERE ancestor_id = ?1 AND depth >= ?2 ORDER BY depth";
+	inline static const char select_ancestors_sql[] = "SELECT ancestor_id, depth FROM entity_closure WHERE descendant_id = ?1 AND depth >= ?2 ORDER BY depth";
+	inline static const char is_descendant_sql[] = "SELECT EXISTS(SELECT 1 FROM entity_closure WHERE ancestor_id = ?1 AND descendant_id = ?2 AND depth > 0)";
 };
 
 }
@@ -62,6 +62,10 @@ SQLRow ExecutedSQL::RowIterator::row() const {
 	return stmt;
 }
 
+SQLStatementRow ExecutedSQL::RowIterator::statement_row() const {
+	return stmt.get();
+}
+
 SQLRow ExecutedSQL::RowIterator::operator*() const {
 	return stmt;
 }
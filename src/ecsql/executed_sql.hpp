@@ -1,6 +1,7 @@
 #pragma once
 
 #include "sql_row.hpp"
+#include "sql_statement_row.hpp"
 
 namespace ecsql {
 
@@ -19,6 +20,8 @@ public:
 		RowIterator operator++(int _);
 
 		SQLRow row() const;
+		// Non-owning, statically dispatched view of the current row
+		SQLStatementRow statement_row() const;
 		SQLRow operator*() const;
 		operator bool() const;
 
@@ -19,19 +19,32 @@ enum class HookType {
 	OnDelete,
 };
 
+// Hook system called for each changed row, from inside SQLite's preupdate hook.
+// Main thread only hooks, e.g. the ones calling into Lua, get copies of the rows changed from a worker thread
+// when `World::update` returns, instead of being called right away.
 class HookSystem {
 public:
+	// Tag for hook systems owned by other objects, e.g. a ComponentCache, which must not be linked into the static list
+	struct Unlisted {};
+
 	template<typename Fn>
-	HookSystem(std::string_view component_name, Fn&& implementation)
+	HookSystem(Unlisted, std::string_view component_name, Fn&& implementation, bool is_main_thread_only = false)
 		: component_name(component_name)
 		, implementation([=](HookType hook, SQLBaseRow& old_row, SQLBaseRow& new_row) { implementation(hook, old_row, new_row); })
+		, is_main_thread_only(is_main_thread_only)
+	{
+	}
+
+	template<typename Fn>
+	HookSystem(std::string_view component_name, Fn&& implementation, bool is_main_thread_only = false)
+		: HookSystem(Unlisted{}, component_name, implementation, is_main_thread_only)
 	{
 		STATIC_LINKED_LIST_INSERT();
 	}
 
 	template<typename Fn>
-	HookSystem(const Component& component, Fn&& implementation)
-		: HookSystem(component.get_name(), implementation)
+	HookSystem(const Component& component, Fn&& implementation, bool is_main_thread_only = false)
+		: HookSystem(component.get_name(), implementation, is_main_thread_only)
 	{
 	}
 
@@ -39,6 +52,9 @@ public:
 
 	std::string component_name;
 	std::function<void(HookType, SQLBaseRow&, SQLBaseRow&)> implementation;
+	bool is_main_thread_only;
+	// Called after the world rolls back a transaction, for hook systems that mirror rows outside SQL
+	std::function<void(sqlite3 *)> on_rollback;
 
 	STATIC_LINKED_LIST_DEFINE(HookSystem);
 };
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <sqlite3.h>
+
+#include "entity.hpp"
+
+namespace ecsql {
+
+// Template entities live in the attached `prefab` database, with the same tables as the world.
+// A prefab is a root entity identified by its name, along with all its descendants and their components.
+struct Prefab {
+	inline static const char schema_sql[] = R"(
+ATTACH ':memory:' AS prefab;
+CREATE TABLE prefab.entity(
+  id INTEGER PRIMARY KEY,
+  name TEXT,
+  parent_id INTEGER REFERENCES entity(id) ON DELETE CASCADE
+);
+CREATE UNIQUE INDEX prefab.entity_prefab_name ON entity(name) WHERE parent_id IS NULL;
+CREATE INDEX prefab.entity_parent_id ON entity(parent_id);
+
+-- Mapping from prefab entities to the entities being instantiated
+CREATE TEMP TABLE prefab_instance(
+  prefab_entity_id INTEGER,
+  entity_id INTEGER PRIMARY KEY,
+  parent_id INTEGER,
+  is_root,
+  path TEXT
+);
+)";
+
+	inline static const char insert_sql[] = "INSERT INTO prefab.entity(name, parent_id) VALUES(?, ?)";
+	inline static const char delete_by_name_sql[] = "DELETE FROM prefab.entity WHERE name = ? AND parent_id IS NULL";
+	// Next ID the world's rowid allocation would give, which never reuses IDs of deleted entities.
+	// Explicit IDs inserted after it also advance the sequence, so later entities come after the instances.
+	inline static const char next_entity_id_sql[] = "SELECT coalesce((SELECT seq FROM main.sqlite_sequence WHERE name = 'entity'), 0) + 1";
+	inline static const char clear_instances_sql[] = "DELETE FROM temp.prefab_instance";
+	// ?1: prefab name, ?2: instance count, ?3: first entity ID, ?4: parent of the roots, ?5: overrides JSON.
+	// Instance `i` gets IDs `[?3 + i * n, ?3 + (i + 1) * n)`, with its root first, where `n` is the prefab entity count.
+	inline static const char map_instances_sql[] = R"(
+WITH RECURSIVE
+  subtree(id, parent_id, depth) AS (
+    SELECT id, NULL, 0 FROM prefab.entity WHERE name = ?1 AND parent_id IS NULL
+    UNION ALL
+    SELECT entity.id, entity.parent_id, subtree.depth + 1
+    FROM prefab.entity JOIN subtree ON entity.parent_id = subtree.id
+  ),
+  ordinal AS (
+    SELECT id, parent_id, row_number() OVER (ORDER BY depth, id) - 1 AS k, count(*) OVER () AS n
+    FROM subtree
+  ),
+  instance(i) AS (
+    SELECT 0 WHERE ?2 > 0
+    UNION ALL
+    SELECT i + 1 FROM instance WHERE i + 1 < ?2
+  )
+INSERT INTO temp.prefab_instance(prefab_entity_id, entity_id, parent_id, is_root, path)
+SELECT
+  ordinal.id,
+  ?3 + instance.i * ordinal.n + ordinal.k,
+  coalesce(?3 + instance.i * ordinal.n + parent.k, ?4),
+  ordinal.k = 0,
+  iif(json_type(?5) = 'array', '$[' || instance.i || ']', '$')
+FROM ordinal
+  CROSS JOIN instance
+  LEFT JOIN ordinal AS parent ON parent.id = ordinal.parent_id
+)";
+	inline static const char instantiate_entities_sql[] = R"(
+INSERT INTO main.entity(id, name, parent_id)
+SELECT prefab_instance.entity_id, entity.name, prefab_instance.parent_id
+FROM temp.prefab_instance JOIN prefab.entity ON entity.id = prefab_instance.prefab_entity_id
+ORDER BY prefab_instance.entity_id
+)";
+};
+
+// Entities created by `World::instantiate`, in a contiguous ID range
+struct PrefabInstances {
+	EntityID first_id = 0;
+	int instance_count = 0;
+	int entities_per_instance = 0;
+
+	EntityID root(int instance) const {
+		return first_id + (EntityID) instance * entities_per_instance;
+	}
+
+	EntityID end_id() const {
+		return root(instance_count);
+	}
+
+	int entity_count() const {
+		return instance_count * entities_per_instance;
+	}
+};
+
+}
@@ -1,4 +1,6 @@
+#include <cctype>
 #include <stdexcept>
+#include <string>
 
 #include <sqlite3.h>
 #include <tracy/Tracy.hpp>
@@ -32,6 +34,11 @@ PreparedSQL::PreparedSQL(sqlite3 *db, std::string_view str, bool is_persistent)
 {
 }
 
+PreparedSQL::PreparedSQL(std::shared_ptr<sqlite3_stmt> stmt)
+	: stmt(stmt)
+{
+}
+
 PreparedSQL& PreparedSQL::bind_null(int index) {
 	sqlite3_bind_null(stmt.get(), index);
 	return *this;
@@ -76,6 +83,131 @@ bool PreparedSQL::busy() const {
 	return sqlite3_stmt_busy(stmt.get());
 }
 
+int PreparedSQL::column_count() const {
+	return sqlite3_column_count(stmt.get());
+}
+
+void PreparedSQL::validate_column_count(int expected_count) const {
+	int count = column_count();
+	if (count != expected_count) {
+		std::string error = "Expected ";
+		error += std::to_string(expected_count);
+		error += " columns, got ";
+		error += std::to_string(count);
+		error += " @ \"";
+		error += sql();
+		error += "\"";
+		throw std::runtime_error(error);
+	}
+}
+
+static const char *storage_name(int type) {
+	switch (type) {
+		case SQLITE_INTEGER: return "INTEGER";
+		case SQLITE_FLOAT: return "REAL";
+		case SQLITE_TEXT: return "TEXT";
+		case SQLITE_BLOB: return "BLOB";
+		default: return "NULL";
+	}
+}
+
+// Column affinity from its declared type, following the rules in https://www.sqlite.org/datatype3.html
+static int declared_affinity(std::string declared_type) {
+	for (char& c : declared_type) {
+		c = toupper((unsigned char) c);
+	}
+	if (declared_type.find("INT") != std::string::npos) {
+		return SQLITE_INTEGER;
+	}
+	else if (declared_type.find("CHAR") != std::string::npos || declared_type.find("CLOB") != std::string::npos || declared_type.find("TEXT") != std::string::npos) {
+		return SQLITE_TEXT;
+	}
+	else if (declared_type.empty() || declared_type.find("BLOB") != std::string::npos) {
+		return SQLITE_BLOB;
+	}
+	else if (declared_type.find("REAL") != std::string::npos || declared_type.find("FLOA") != std::string::npos || declared_type.find("DOUB") != std::string::npos) {
+		return SQLITE_FLOAT;
+	}
+	else {
+		// NUMERIC affinity stores either integers or reals
+		return SQLITE_NULL;
+	}
+}
+
+static bool is_affinity_compatible(int affinity, int expected_type) {
+	switch (affinity) {
+		case SQLITE_INTEGER:
+			return expected_type == SQLITE_INTEGER || expected_type == SQLITE_FLOAT;
+		case SQLITE_FLOAT:
+			return expected_type == SQLITE_FLOAT;
+		case SQLITE_TEXT:
+		case SQLITE_BLOB:
+			return expected_type == SQLITE_TEXT || expected_type == SQLITE_BLOB;
+		default:
+			return expected_type == SQLITE_INTEGER || expected_type == SQLITE_FLOAT;
+	}
+}
+
+static bool is_storage_compatible(int type, const ColumnStorage& expected) {
+	switch (type) {
+		case SQLITE_NULL:
+			return expected.is_nullable;
+		case SQLITE_INTEGER:
+			return expected.type != SQLITE_BLOB;
+		case SQLITE_FLOAT:
+			return expected.type == SQLITE_FLOAT || expected.type == SQLITE_TEXT;
+		case SQLITE_TEXT:
+			return expected.type == SQLITE_TEXT || expected.type == SQLITE_BLOB;
+		default:
+			return expected.type == SQLITE_BLOB || expected.type == SQLITE_TEXT;
+	}
+}
+
+void PreparedSQL::validate_declared_types(std::span<const ColumnStorage> expected) const {
+	for (int i = 0; i < expected.size() && i < column_count(); i++) {
+		const char *declared_type = sqlite3_column_decltype(stmt.get(), i);
+		if (declared_type && *declared_type && !is_affinity_compatible(declared_affinity(declared_type), expected[i].type)) {
+			std::string error = "Column ";
+			error += std::to_string(i);
+			error += " is declared as '";
+			error += declared_type;
+			error += "', but is read as ";
+			error += storage_name(expected[i].type);
+			error += " @ \"";
+			error += sql();
+			error += "\"";
+			throw std::runtime_error(error);
+		}
+	}
+}
+
+void PreparedSQL::validate_row_storage(std::span<const ColumnStorage> expected) const {
+	for (int i = 0; i < expected.size() && i < column_count(); i++) {
+		int type = sqlite3_column_type(stmt.get(), i);
+		if (!is_storage_compatible(type, expected[i])) {
+			std::string error = "Column ";
+			error += std::to_string(i);
+			error += " holds ";
+			error += storage_name(type);
+			error += ", but is read as ";
+			error += storage_name(expected[i].type);
+			error += " @ \"";
+			error += sql();
+			error += "\"";
+			throw std::runtime_error(error);
+		}
+	}
+}
+
+int PreparedSQL::status(int op, bool reset_counter) const {
+	return sqlite3_stmt_status(stmt.get(), op, reset_counter);
+}
+
+std::string_view PreparedSQL::sql() const {
+	const char *str = sqlite3_sql(stmt.get());
+	return str ? str : "";
+}
+
 PreparedSQL& PreparedSQL::reset() {
 	sqlite3_reset(stmt.get());
 	return *this;
@@ -11,6 +11,7 @@ public:
 	PreparedSQL() = default;
 	PreparedSQL(sqlite3 *db, std::string_view str);
 	PreparedSQL(sqlite3 *db, std::string_view str, bool is_persistent);
+	explicit PreparedSQL(std::shared_ptr<sqlite3_stmt> stmt);
 
 	PreparedSQL& bind_null(int index);
 	PreparedSQL& bind_bool(int index, bool value);
@@ -32,6 +33,21 @@ public:
 	}
 
 	bool busy() const;
+	int column_count() const;
+	// Throws if the statement does not return exactly the columns read by `get<Types...>`
+	template<typename... Types>
+	void validate_columns() const {
+		validate_column_count(column_count_of_all<Types...>());
+	}
+	void validate_column_count(int expected_count) const;
+	// Throws if a column's declared type has an affinity that doesn't match the storage class read from it.
+	// Columns without declared types, like expressions and untyped component fields, are not checked.
+	void validate_declared_types(std::span<const ColumnStorage> expected) const;
+	// Throws if the current row holds values that would be lossily converted when read, like NULL into non-optionals
+	void validate_row_storage(std::span<const ColumnStorage> expected) const;
+	// Value of a `SQLITE_STMTSTATUS_*` counter, optionally resetting it to 0
+	int status(int op, bool reset_counter = false) const;
+	std::string_view sql() const;
 	PreparedSQL& reset();
 	ExecutedSQL execute();
 
@@ -132,6 +148,11 @@ private:
 		return bind_text(index++, value);
 	}
 
+	// Arguments are taken by value, so the text must be copied by SQLite
+	template<> PreparedSQL& bind_advance(int& index, std::string value) {
+		return bind_text(index++, std::string_view(value), SQLITE_TRANSIENT);
+	}
+
 	template<> PreparedSQL& bind_advance(int& index, std::string_view value) {
 		return bind_text(index++, value);
 	}
@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <cctype>
+
+#include <tracy/Tracy.hpp>
+
+#include "prepared_sql_cache.hpp"
+
+namespace ecsql {
+
+PreparedSQLCache::PreparedSQLCache(size_t capacity)
+	: capacity(capacity)
+{
+}
+
+// Copies share a control block that resets the statement once the last of them is released
+static PreparedSQL lend(const std::shared_ptr<sqlite3_stmt>& stmt) {
+	return PreparedSQL(std::shared_ptr<sqlite3_stmt>(stmt.get(), [stmt](sqlite3_stmt *lent_stmt) {
+		sqlite3_reset(lent_stmt);
+	}));
+}
+
+// Whether `sql` starts with a statement that changes the schema, skipping whitespace and comments
+static bool is_schema_statement(std::string_view sql) {
+	while (!sql.empty()) {
+		if (isspace((unsigned char) sql.front())) {
+			sql.remove_prefix(1);
+		}
+		else if (sql.starts_with("--")) {
+			size_t end = sql.find('\n');
+			sql.remove_prefix(end != std::string_view::npos ? end : sql.size());
+		}
+		else if (sql.starts_with("/*")) {
+			size_t end = sql.find("*/");
+			sql.remove_prefix(end != std::string_view::npos ? end + 2 : sql.size());
+		}
+		else {
+			break;
+		}
+	}
+	for (std::string_view keyword : { "CREATE", "DROP", "ALTER", "ATTACH", "DETACH" }) {
+		if (sql.size() >= keyword.size() && std::equal(keyword.begin(), keyword.end(), sql.begin(), [](char a, char b) { return a == toupper((unsigned char) b); })) {
+			return true;
+		}
+	}
+	return false;
+}
+
+PreparedSQL PreparedSQLCache::get(sqlite3 *db, std::string_view sql) {
+	auto it = index.find(sql);
+	if (it != index.end()) {
+		const std::shared_ptr<sqlite3_stmt>& stmt = it->second->second;
+		if (stmt.use_count() > 1) {
+			stats.misses++;
+			return PreparedSQL(db, sql, false);
+		}
+		stats.hits++;
+		entries.splice(entries.begin(), entries, it->second);
+		return lend(stmt);
+	}
+
+	ZoneScoped;
+	stats.misses++;
+	PreparedSQL prepared_sql(db, sql, true);
+	if (!sqlite3_stmt_readonly(prepared_sql.get_stmt().get()) && is_schema_statement(sql)) {
+		clear();
+		return prepared_sql;
+	}
+	if (capacity == 0) {
+		return prepared_sql;
+	}
+	if (entries.size() >= capacity) {
+		index.erase(entries.back().first);
+		entries.pop_back();
+		stats.evictions++;
+	}
+	entries.emplace_front(std::string(sql), prepared_sql.get_stmt());
+	index.emplace(entries.front().first, entries.begin());
+	return lend(entries.front().second);
+}
+
+void PreparedSQLCache::clear() {
+	index.clear();
+	entries.clear();
+}
+
+size_t PreparedSQLCache::size() const {
+	return entries.size();
+}
+
+const PreparedSQLCache::Stats& PreparedSQLCache::get_stats() const {
+	return stats;
+}
+
+}
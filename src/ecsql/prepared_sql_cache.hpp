@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+#include "prepared_sql.hpp"
+
+typedef struct sqlite3 sqlite3;
+
+namespace ecsql {
+
+// Bounded LRU cache of statements for ad-hoc SQL, keyed by SQL text.
+// Statements are lent out and reset when the last copy is released, so rows left unread don't keep tables locked.
+// The World clears the cache where it changes the schema. Schema statements run through the cache itself,
+// like `CREATE` or `DROP`, are not cached and clear it too. Other schema changes are handled by SQLite,
+// which prepares cached statements again when they are stepped.
+class PreparedSQLCache {
+public:
+	struct Stats {
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint64_t evictions = 0;
+	};
+
+	PreparedSQLCache(size_t capacity = 128);
+
+	// Statements still lent to someone else are not shared, a new uncached one is prepared instead
+	PreparedSQL get(sqlite3 *db, std::string_view sql);
+	void clear();
+
+	size_t size() const;
+	const Stats& get_stats() const;
+
+private:
+	size_t capacity;
+	// Most recently used first
+	std::list<std::pair<std::string, std::shared_ptr<sqlite3_stmt>>> entries;
+	// Keys point to the strings in `entries`
+	std::unordered_map<std::string_view, std::list<std::pair<std::string, std::shared_ptr<sqlite3_stmt>>>::iterator> index;
+	Stats stats;
+};
+
+}
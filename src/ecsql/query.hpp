@@ -0,0 +1,111 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "executed_sql.hpp"
+#include "prepared_sql.hpp"
+#include "sql_statement_row.hpp"
+
+namespace ecsql {
+
+// Views into SQLite memory are only valid until the next row is stepped, so they cannot be fetched in batches
+template<typename T>
+constexpr bool is_row_view = std::is_pointer_v<T>
+	|| std::is_same_v<T, std::string_view>
+	|| std::is_same_v<T, std::span<const uint8_t>>;
+
+// PreparedSQL with typed results, decoded many rows at a time into contiguous buffers.
+// The column count and declared column types are validated against `Columns...` when constructed,
+// and so are the storage classes in the first row of each execution, for untyped columns.
+template<typename... Columns>
+class Query {
+public:
+	static_assert(sizeof...(Columns) > 0, "Query needs at least one column type");
+	static_assert((!is_row_view<Columns> && ...), "Use std::string or std::vector<uint8_t> instead of views in Query columns");
+
+	using Row = std::conditional_t<sizeof...(Columns) == 1, std::tuple_element_t<0, std::tuple<Columns...>>, std::tuple<Columns...>>;
+	static constexpr int column_count = column_count_of_all<Columns...>();
+
+	Query() = default;
+	Query(PreparedSQL prepared_sql)
+		: prepared_sql(std::move(prepared_sql))
+	{
+		this->prepared_sql.template validate_columns<Columns...>();
+		this->prepared_sql.validate_declared_types(column_storage);
+	}
+	Query(sqlite3 *db, std::string_view sql, bool is_persistent = true)
+		: Query(PreparedSQL(db, sql, is_persistent))
+	{
+	}
+
+	// Binds parameters and starts a new execution, abandoning the previous one if not fully fetched
+	template<typename... Args>
+	Query& operator()(Args&&... args) {
+		current = prepared_sql(std::forward<Args>(args)...).begin();
+		if (current) {
+			prepared_sql.validate_row_storage(column_storage);
+		}
+		return *this;
+	}
+
+	bool done() const {
+		return !current;
+	}
+
+	// Decodes up to `rows.size()` rows, returning how many were written. Returns 0 once the results are over.
+	size_t fetch_batch(std::span<Row> rows) {
+		size_t count = 0;
+		for (; count < rows.size() && current; ++current) {
+			rows[count++] = current.statement_row().template get<Columns...>();
+		}
+		return count;
+	}
+
+	std::vector<Row> fetch_all() {
+		std::vector<Row> rows;
+		for (; current; ++current) {
+			rows.push_back(current.statement_row().template get<Columns...>());
+		}
+		return rows;
+	}
+
+	// Decodes the remaining rows into one vector per column
+	std::tuple<std::vector<Columns>...> fetch_all_soa() {
+		std::tuple<std::vector<Columns>...> columns;
+		for (; current; ++current) {
+			std::tuple<Columns...> values = decode_tuple(current.statement_row());
+			[&]<size_t... I>(std::index_sequence<I...>) {
+				(std::get<I>(columns).push_back(std::move(std::get<I>(values))), ...);
+			}(std::index_sequence_for<Columns...>());
+		}
+		return columns;
+	}
+
+	PreparedSQL& get_prepared_sql() {
+		return prepared_sql;
+	}
+
+private:
+	inline static const std::array<ColumnStorage, column_count> column_storage = column_storage_of_all<Columns...>();
+
+	PreparedSQL prepared_sql;
+	ExecutedSQL::RowIterator current;
+
+	static std::tuple<Columns...> decode_tuple(const SQLStatementRow& row) {
+		if constexpr (sizeof...(Columns) == 1) {
+			return std::tuple<Columns...>(row.get<Columns...>());
+		}
+		else {
+			return row.get<Columns...>();
+		}
+	}
+};
+
+}
@@ -0,0 +1,89 @@
+#include <sqlite3.h>
+#include <tracy/Tracy.hpp>
+
+#include "prepared_sql.hpp"
+#include "query_plan.hpp"
+
+namespace ecsql {
+
+// Eponymous virtual tables are not in the schema, so they are never flagged
+static bool is_component_table(sqlite3 *db, std::string_view table) {
+	std::string table_name(table);
+	if (sqlite3_table_column_metadata(db, nullptr, table_name.c_str(), "entity_id", nullptr, nullptr, nullptr, nullptr, nullptr) != SQLITE_OK) {
+		return false;
+	}
+	PreparedSQL find_table(db, "SELECT 1 FROM sqlite_schema WHERE type = 'table' AND name = ?");
+	return (bool) find_table(table).begin();
+}
+
+// Table name that follows "SCAN " or "SEARCH "
+static std::string_view step_table(std::string_view detail) {
+	size_t start = detail.find(' ');
+	if (start == std::string_view::npos) {
+		return {};
+	}
+	detail.remove_prefix(start + 1);
+	// SQLite versions before 3.36 say "SCAN TABLE t"
+	if (detail.starts_with("TABLE ")) {
+		detail.remove_prefix(6);
+	}
+	return detail.substr(0, detail.find(' '));
+}
+
+// "SEARCH t USING AUTOMATIC COVERING INDEX (a=? AND b=?)" -> "CREATE INDEX t_a_b ON t(a, b)"
+static std::string suggest_index(std::string_view table, std::string_view detail) {
+	size_t open = detail.find('(');
+	size_t close = detail.rfind(')');
+	if (open == std::string_view::npos || close == std::string_view::npos || close < open) {
+		return {};
+	}
+	std::string_view constraints = detail.substr(open + 1, close - open - 1);
+
+	std::string index_name(table);
+	std::string columns;
+	while (!constraints.empty()) {
+		size_t and_position = constraints.find(" AND ");
+		std::string_view constraint = constraints.substr(0, and_position);
+		std::string_view column = constraint.substr(0, constraint.find_first_of("=<>"));
+		index_name += '_';
+		index_name += column;
+		if (!columns.empty()) {
+			columns += ", ";
+		}
+		columns += column;
+		if (and_position == std::string_view::npos) {
+			break;
+		}
+		constraints.remove_prefix(and_position + 5);
+	}
+	if (columns.empty()) {
+		return {};
+	}
+	return "CREATE INDEX " + index_name + " ON " + std::string(table) + "(" + columns + ")";
+}
+
+std::vector<QueryPlanStep> explain_query_plan(sqlite3 *db, std::string_view sql) {
+	ZoneScoped;
+	std::string explain_sql = "EXPLAIN QUERY PLAN ";
+	explain_sql += sql;
+
+	std::vector<QueryPlanStep> steps;
+	PreparedSQL explain(db, explain_sql);
+	for (SQLRow row : explain()) {
+		auto [id, parent_id, unused, detail] = row.get<int, int, int, std::string>();
+		steps.push_back({ id, parent_id, detail });
+		QueryPlanStep& step = steps.back();
+
+		std::string_view table = step_table(detail);
+		if (detail.starts_with("SCAN ") && is_component_table(db, table)) {
+			step.is_full_scan = true;
+		}
+		if (detail.find("AUTOMATIC") != std::string::npos) {
+			step.is_automatic_index = true;
+			step.suggested_index = suggest_index(table, detail);
+		}
+	}
+	return steps;
+}
+
+}
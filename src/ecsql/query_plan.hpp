@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+typedef struct sqlite3 sqlite3;
+
+namespace ecsql {
+
+// One row of `EXPLAIN QUERY PLAN`, flagged with the problems a system should not have in its hot path
+struct QueryPlanStep {
+	int id;
+	int parent_id;
+	std::string detail;
+	// Scans every row of a component table, i.e. any table with an `entity_id` column
+	bool is_full_scan = false;
+	// SQLite builds a temporary index every time the statement runs
+	bool is_automatic_index = false;
+	// `CREATE INDEX` statement that would replace the automatic index, if any
+	std::string suggested_index;
+};
+
+std::vector<QueryPlanStep> explain_query_plan(sqlite3 *db, std::string_view sql);
+
+}
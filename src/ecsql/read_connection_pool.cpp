@@ -0,0 +1,100 @@
+#include <stdexcept>
+
+#include <tracy/Tracy.hpp>
+
+#include "read_connection_pool.hpp"
+
+namespace ecsql {
+
+static const int READ_CONNECTION_BUSY_TIMEOUT_MS = 1000;
+
+ReadConnection::ReadConnection(ReadConnectionPool& pool, std::unique_ptr<sqlite3, sqlite3_close_v2_deleter>&& db)
+	: pool(&pool)
+	, db(std::move(db))
+{
+	begin_read();
+}
+
+ReadConnection::~ReadConnection() {
+	if (db) {
+		end_read();
+		pool->release(std::move(db));
+	}
+}
+
+sqlite3 *ReadConnection::get_db() const {
+	return db.get();
+}
+
+void ReadConnection::begin_read() {
+	end_read();
+	// Reading the schema version opens the read transaction right away, pinning the current snapshot
+	execute_sql_script(db.get(), "BEGIN; PRAGMA schema_version;");
+	is_reading = true;
+}
+
+void ReadConnection::end_read() {
+	if (is_reading) {
+		sqlite3_exec(db.get(), "COMMIT", nullptr, nullptr, nullptr);
+		is_reading = false;
+	}
+}
+
+PreparedSQL ReadConnection::prepare_sql(std::string_view sql, bool is_persistent) {
+	return PreparedSQL(db.get(), sql, is_persistent);
+}
+
+ReadConnectionPool::ReadConnectionPool(std::string_view db_uri)
+	: db_uri(db_uri)
+{
+}
+
+ReadConnection ReadConnectionPool::acquire() {
+	ZoneScoped;
+	std::unique_ptr<sqlite3, sqlite3_close_v2_deleter> db;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!available_connections.empty()) {
+			db = std::move(available_connections.back());
+			available_connections.pop_back();
+		}
+	}
+	if (!db) {
+		db = open_connection();
+	}
+	apply_connection_setups(db.get());
+	return ReadConnection(*this, std::move(db));
+}
+
+void ReadConnectionPool::add_connection_setup(std::function<void(sqlite3 *)> setup) {
+	std::lock_guard<std::mutex> lock(mutex);
+	connection_setups.push_back(std::move(setup));
+}
+
+void ReadConnectionPool::apply_connection_setups(sqlite3 *db) {
+	std::lock_guard<std::mutex> lock(mutex);
+	size_t& applied_count = applied_setup_counts[db];
+	for (; applied_count < connection_setups.size(); applied_count++) {
+		connection_setups[applied_count](db);
+	}
+}
+
+std::unique_ptr<sqlite3, sqlite3_close_v2_deleter> ReadConnectionPool::open_connection() {
+	ZoneScoped;
+	sqlite3 *db;
+	int res = sqlite3_open_v2(db_uri.c_str(), &db, SQLITE_OPEN_READONLY | SQLITE_OPEN_URI, nullptr);
+	std::unique_ptr<sqlite3, sqlite3_close_v2_deleter> db_deleter(db);
+	if (res != SQLITE_OK) {
+		throw std::runtime_error(sqlite3_errmsg(db));
+	}
+	sqlite3_busy_timeout(db, READ_CONNECTION_BUSY_TIMEOUT_MS);
+	execute_sql_script(db, "PRAGMA query_only = ON");
+	return db_deleter;
+}
+
+void ReadConnectionPool::release(std::unique_ptr<sqlite3, sqlite3_close_v2_deleter>&& db) {
+	std::lock_guard<std::mutex> lock(mutex);
+	available_connections.push_back(std::move(db));
+}
+
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "prepared_sql.hpp"
+#include "sql_utility.hpp"
+
+namespace ecsql {
+
+class ReadConnectionPool;
+
+// Read-only connection to the world database, borrowed from a ReadConnectionPool.
+// While alive, it holds a read transaction, so every query sees the same snapshot of the last committed frame.
+// Statements prepared in a ReadConnection must not outlive it.
+class ReadConnection {
+public:
+	ReadConnection(ReadConnectionPool& pool, std::unique_ptr<sqlite3, sqlite3_close_v2_deleter>&& db);
+	ReadConnection(ReadConnection&& other) = default;
+	~ReadConnection();
+
+	sqlite3 *get_db() const;
+	// End the current read transaction and/or start a new one, seeing the last committed frame.
+	// Prepared statements stay valid across snapshots.
+	void begin_read();
+	void end_read();
+	PreparedSQL prepare_sql(std::string_view sql, bool is_persistent = false);
+
+	template<typename... Args>
+	ExecutedSQL execute_sql(std::string_view sql, Args&&... args) {
+		return prepare_sql(sql)(std::forward<Args>(args)...);
+	}
+
+private:
+	ReadConnectionPool *pool;
+	std::unique_ptr<sqlite3, sqlite3_close_v2_deleter> db;
+	bool is_reading = false;
+};
+
+// Pool of read-only connections that attach to the same database as the World connection.
+// Connections are opened on demand and reused afterwards, so that readers in other threads don't wait on each other.
+class ReadConnectionPool {
+public:
+	ReadConnectionPool(std::string_view db_uri);
+
+	ReadConnection acquire();
+	// Run `setup` in every connection, e.g. to register SQL functions and virtual tables.
+	// Connections in use get it the next time they are acquired.
+	void add_connection_setup(std::function<void(sqlite3 *)> setup);
+
+private:
+	std::string db_uri;
+	std::vector<std::unique_ptr<sqlite3, sqlite3_close_v2_deleter>> available_connections;
+	std::vector<std::function<void(sqlite3 *)>> connection_setups;
+	// Number of setups already run in each connection
+	std::unordered_map<sqlite3 *, size_t> applied_setup_counts;
+	std::mutex mutex;
+
+	std::unique_ptr<sqlite3, sqlite3_close_v2_deleter> open_connection();
+	void apply_connection_setups(sqlite3 *db);
+	void release(std::unique_ptr<sqlite3, sqlite3_close_v2_deleter>&& db);
+
+	friend class ReadConnection;
+};
+
+}
@@ -19,7 +19,19 @@ int SQLHookRow::column_count() const {
 }
 
 SQLValue SQLHookRow::column_value(int index) const {
-	sqlite3_value *value;
+	if (index < 0 || index >= MAX_CACHED_COLUMNS) {
+		return fetch_value(index);
+	}
+	uint64_t bit = uint64_t(1) << index;
+	if (!(cached_columns & bit)) {
+		cached_values[index] = fetch_value(index);
+		cached_columns |= bit;
+	}
+	return cached_values[index];
+}
+
+sqlite3_value *SQLHookRow::fetch_value(int index) const {
+	sqlite3_value *value = nullptr;
 	if (use_new_row) {
 		sqlite3_preupdate_new(db, index, &value);
 	}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <span>
 #include <string_view>
 
@@ -28,9 +29,16 @@ struct SQLHookRow : public SQLBaseRow {
 	std::span<const uint8_t> column_blob(int index) const override;
 
 protected:
+	// Values are cached per row, as hooks usually read each column more than once
+	static constexpr int MAX_CACHED_COLUMNS = 64;
+
 	sqlite3 *db;
 	sqlite3_int64 rowid;
 	bool use_new_row;
+	mutable uint64_t cached_columns = 0;
+	mutable sqlite3_value *cached_values[MAX_CACHED_COLUMNS];
+
+	sqlite3_value *fetch_value(int index) const;
 };
 
 }
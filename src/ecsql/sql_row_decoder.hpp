@@ -0,0 +1,208 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <reflect>
+#include <sqlite3.h>
+
+#include "is_optional.hpp"
+
+namespace ecsql {
+
+// Number of SQL columns read by `get<Types...>`: optionals read the columns of their value type
+// and structs read one column per field, recursively.
+template<typename T>
+constexpr int column_count_of() {
+	if constexpr (is_optional<T>) {
+		return column_count_of<typename T::value_type>();
+	}
+	else if constexpr (
+		std::is_arithmetic_v<T>
+		|| std::is_pointer_v<T>
+		|| std::is_same_v<T, std::string>
+		|| std::is_same_v<T, std::string_view>
+		|| std::is_same_v<T, std::span<const uint8_t>>
+		|| std::is_same_v<T, std::vector<uint8_t>>
+	) {
+		return 1;
+	}
+	else {
+		return []<size_t... I>(std::index_sequence<I...>) {
+			return (0 + ... + column_count_of<std::remove_cvref_t<decltype(reflect::get<I>(std::declval<T&>()))>>());
+		}(std::make_index_sequence<reflect::size<T>()>());
+	}
+}
+
+template<typename... Types>
+constexpr int column_count_of_all() {
+	return (0 + ... + column_count_of<Types>());
+}
+
+// Storage class read by `get<T>` from a single column
+struct ColumnStorage {
+	// SQLITE_INTEGER, SQLITE_FLOAT, SQLITE_TEXT or SQLITE_BLOB
+	int type;
+	// Optionals also read NULL
+	bool is_nullable;
+};
+
+template<typename T>
+void append_column_storage(ColumnStorage *storage, int& index, bool is_nullable = false) {
+	if constexpr (is_optional<T>) {
+		append_column_storage<typename T::value_type>(storage, index, true);
+	}
+	else if constexpr (std::is_integral_v<T>) {
+		storage[index++] = { SQLITE_INTEGER, is_nullable };
+	}
+	else if constexpr (std::is_floating_point_v<T>) {
+		storage[index++] = { SQLITE_FLOAT, is_nullable };
+	}
+	else if constexpr (std::is_pointer_v<T> || std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>) {
+		storage[index++] = { SQLITE_TEXT, is_nullable };
+	}
+	else if constexpr (std::is_same_v<T, std::span<const uint8_t>> || std::is_same_v<T, std::vector<uint8_t>>) {
+		storage[index++] = { SQLITE_BLOB, is_nullable };
+	}
+	else {
+		reflect::for_each<T>([&](auto I) {
+			append_column_storage<std::remove_cvref_t<decltype(reflect::get<I>(std::declval<T&>()))>>(storage, index, is_nullable);
+		});
+	}
+}
+
+// Storage class of each column read by `get<Types...>`, in order
+template<typename... Types>
+std::array<ColumnStorage, column_count_of_all<Types...>()> column_storage_of_all() {
+	std::array<ColumnStorage, column_count_of_all<Types...>()> storage;
+	int index = 0;
+	(append_column_storage<Types>(storage.data(), index), ...);
+	return storage;
+}
+
+// Typed column decoding shared by row implementations.
+// `Row` provides the `column_*` accessors, which are called without virtual dispatch unless `Row` declares them virtual.
+template<typename Row>
+struct SQLRowDecoder {
+	template<typename... Types> auto get(int index = 0) const {
+		if constexpr (sizeof...(Types) == 1) {
+			return get_advance<Types...>(index);
+		}
+		else {
+			std::tuple<Types...> tuple;
+			[&]<std::size_t... I> (std::index_sequence<I...>) {
+				((std::get<I>(tuple) = get_advance<std::remove_cvref_t<decltype(std::get<I>(tuple))>>(index)), ...);
+			} (std::index_sequence_for<Types...>());
+			return tuple;
+		}
+	}
+
+protected:
+	const Row& row() const {
+		return static_cast<const Row&>(*this);
+	}
+
+	template<typename T> T get_advance(int& index) const
+	requires is_optional<T>
+	{
+		if (row().column_is_null(index)) {
+			// make sure to advance the correct amount of columns
+			get_advance<typename T::value_type>(index);
+			return std::nullopt;
+		}
+		else {
+			return get_advance<typename T::value_type>(index);
+		}
+	}
+
+	template<typename T> T get_advance(int& index) const
+	requires (not is_optional<T>) {
+		T value;
+		reflect::for_each<T>([&](auto I) {
+			auto&& field = reflect::get<I>(value);
+			field = get_advance<std::remove_cvref_t<decltype(field)>>(index);
+		});
+		return value;
+	}
+
+	template<> bool get_advance(int& index) const {
+		return row().column_bool(index++);
+	}
+
+	template<> char get_advance(int& index) const {
+		return row().column_int(index++);
+	}
+	template<> unsigned char get_advance(int& index) const {
+		return row().column_int(index++);
+	}
+
+	template<> short get_advance(int& index) const {
+		return row().column_int(index++);
+	}
+	template<> unsigned short get_advance(int& index) const {
+		return row().column_int(index++);
+	}
+
+	template<> int get_advance(int& index) const {
+		return row().column_int(index++);
+	}
+	template<> unsigned int get_advance(int& index) const {
+		return row().column_int(index++);
+	}
+
+	template<> long get_advance(int& index) const {
+		return row().column_int64(index++);
+	}
+	template<> unsigned long get_advance(int& index) const {
+		return row().column_int64(index++);
+	}
+
+	template<> long long get_advance(int& index) const {
+		return row().column_int64(index++);
+	}
+	template<> unsigned long long get_advance(int& index) const {
+		return row().column_int64(index++);
+	}
+
+	template<> float get_advance(int& index) const {
+		return row().column_double(index++);
+	}
+
+	template<> double get_advance(int& index) const {
+		return row().column_double(index++);
+	}
+
+	template<> const unsigned char *get_advance(int& index) const {
+		return (const unsigned char *) row().column_text(index++).data();
+	}
+
+	template<> const char *get_advance(int& index) const {
+		return (const char *) row().column_text(index++).data();
+	}
+
+	template<> std::string get_advance(int& index) const {
+		std::string_view text = row().column_text(index++);
+		return std::string(text);
+	}
+
+	template<> std::string_view get_advance(int& index) const {
+		return row().column_text(index++);
+	}
+
+	template<> std::span<const uint8_t> get_advance(int& index) const {
+		return row().column_blob(index++);
+	}
+
+	template<> std::vector<uint8_t> get_advance(int& index) const {
+		std::span<const uint8_t> span = row().column_blob(index++);
+		return std::vector<uint8_t>(span.begin(), span.end());
+	}
+};
+
+}
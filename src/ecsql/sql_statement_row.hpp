@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+#include <sqlite3.h>
+
+#include "sql_row_decoder.hpp"
+
+namespace ecsql {
+
+// Non-virtual view over the current row of a statement, for hot loops.
+// Unlike SQLRow, it does not own the statement and its accessors can be inlined.
+struct SQLStatementRow : public SQLRowDecoder<SQLStatementRow> {
+	SQLStatementRow(sqlite3_stmt *stmt)
+		: stmt(stmt)
+	{
+	}
+
+	int column_count() const {
+		return sqlite3_column_count(stmt);
+	}
+
+	int column_type(int index) const {
+		return sqlite3_column_type(stmt, index);
+	}
+	bool column_is_null(int index) const {
+		return column_type(index) == SQLITE_NULL;
+	}
+
+	bool column_bool(int index) const {
+		return sqlite3_column_int(stmt, index);
+	}
+	int column_int(int index) const {
+		return sqlite3_column_int(stmt, index);
+	}
+	sqlite3_int64 column_int64(int index) const {
+		return sqlite3_column_int64(stmt, index);
+	}
+	double column_double(int index) const {
+		return sqlite3_column_double(stmt, index);
+	}
+	std::string_view column_text(int index) const {
+		const unsigned char *text = sqlite3_column_text(stmt, index);
+		int size = sqlite3_column_bytes(stmt, index);
+		return std::string_view((const char *) text, size);
+	}
+	std::span<const uint8_t> column_blob(int index) const {
+		const uint8_t *data = (const uint8_t *) sqlite3_column_blob(stmt, index);
+		int size = sqlite3_column_bytes(stmt, index);
+		return std::span<const uint8_t>(data, size);
+	}
+
+	sqlite3_stmt *stmt;
+};
+
+}
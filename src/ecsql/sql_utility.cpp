@@ -1,4 +1,5 @@
 #include <cctype>
+#include <iostream>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -20,6 +21,31 @@ void execute_sql_script(sqlite3 *db, const char *sql) {
 	}
 }
 
+SerializedDatabase serialize_database(sqlite3 *db, const char *db_name) {
+	SerializedDatabase serialized;
+	serialized.data.reset(sqlite3_serialize(db, db_name, &serialized.size, 0));
+	if (!serialized.data) {
+		std::cerr << "Error serializing db \"" << db_name << "\": " << sqlite3_errmsg(db) << std::endl;
+	}
+	return serialized;
+}
+
+std::unique_ptr<sqlite3, sqlite3_close_v2_deleter> deserialize_database(SerializedDatabase&& serialized) {
+	sqlite3 *db;
+	int res = sqlite3_open_v2(":memory:", &db, SQLITE_OPEN_READWRITE, nullptr);
+	std::unique_ptr<sqlite3, sqlite3_close_v2_deleter> db_deleter(db);
+	if (res != SQLITE_OK) {
+		return nullptr;
+	}
+	sqlite3_int64 size = serialized.size;
+	res = sqlite3_deserialize(db, "main", serialized.data.release(), size, size, SQLITE_DESERIALIZE_FREEONCLOSE | SQLITE_DESERIALIZE_READONLY);
+	if (res != SQLITE_OK) {
+		std::cerr << "Error deserializing db: " << sqlite3_errmsg(db) << std::endl;
+		return nullptr;
+	}
+	return db_deleter;
+}
+
 std::string_view extract_identifier(std::string_view field) {
 	auto it = field.cbegin();
 	while (it != field.cend() && isspace(*it)) {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <string_view>
 
 #include <sqlite3.h>
@@ -20,7 +21,20 @@ struct sqlite3_close_v2_deleter {
 	}
 };
 
+// Database contents as returned by `sqlite3_serialize`
+struct SerializedDatabase {
+	std::unique_ptr<unsigned char, sqlite3_free_deleter> data;
+	sqlite3_int64 size = 0;
+
+	explicit operator bool() const {
+		return (bool) data;
+	}
+};
+
 void execute_sql_script(sqlite3 *db, const char *sql);
+SerializedDatabase serialize_database(sqlite3 *db, const char *db_name = "main");
+// Opens a read-only in-memory connection over serialized contents, taking ownership of them
+std::unique_ptr<sqlite3, sqlite3_close_v2_deleter> deserialize_database(SerializedDatabase&& serialized);
 std::string_view extract_identifier(std::string_view field);
 
 }
@@ -0,0 +1,111 @@
+#include <algorithm>
+
+#include "sql_value_row.hpp"
+
+namespace ecsql {
+
+SQLValueRow::SQLValueRow(sqlite3 *db, bool use_new_row) {
+	int count = sqlite3_preupdate_count(db);
+	sqlite3_value **values = allocate_values(count);
+	for (int i = 0; i < count; i++) {
+		sqlite3_value *value = nullptr;
+		if (use_new_row) {
+			sqlite3_preupdate_new(db, i, &value);
+		}
+		else {
+			sqlite3_preupdate_old(db, i, &value);
+		}
+		values[i] = sqlite3_value_dup(value);
+	}
+}
+
+SQLValueRow::SQLValueRow(sqlite3_stmt *stmt) {
+	int count = sqlite3_column_count(stmt);
+	sqlite3_value **values = allocate_values(count);
+	for (int i = 0; i < count; i++) {
+		values[i] = sqlite3_value_dup(sqlite3_column_value(stmt, i));
+	}
+}
+
+SQLValueRow::SQLValueRow(SQLValueRow&& other) {
+	*this = std::move(other);
+}
+
+SQLValueRow& SQLValueRow::operator=(SQLValueRow&& other) {
+	if (this != &other) {
+		free_values();
+		value_count = other.value_count;
+		heap_values = std::move(other.heap_values);
+		if (!heap_values) {
+			std::copy(other.inline_values, other.inline_values + value_count, inline_values);
+		}
+		other.value_count = 0;
+	}
+	return *this;
+}
+
+SQLValueRow::~SQLValueRow() {
+	free_values();
+}
+
+int SQLValueRow::column_count() const {
+	return value_count;
+}
+
+SQLValue SQLValueRow::column_value(int index) const {
+	return values()[index];
+}
+
+int SQLValueRow::column_type(int index) const {
+	return column_value(index).get_type();
+}
+
+bool SQLValueRow::column_bool(int index) const {
+	return column_value(index).get_bool();
+}
+
+int SQLValueRow::column_int(int index) const {
+	return column_value(index).get_int();
+}
+
+sqlite3_int64 SQLValueRow::column_int64(int index) const {
+	return column_value(index).get_int64();
+}
+
+double SQLValueRow::column_double(int index) const {
+	return column_value(index).get_double();
+}
+
+std::string_view SQLValueRow::column_text(int index) const {
+	return column_value(index).get_text();
+}
+
+std::span<const uint8_t> SQLValueRow::column_blob(int index) const {
+	return column_value(index).get_blob();
+}
+
+sqlite3_value **SQLValueRow::allocate_values(int count) {
+	value_count = count;
+	if (count > INLINE_VALUE_COUNT) {
+		heap_values = std::make_unique<sqlite3_value *[]>(count);
+		return heap_values.get();
+	}
+	else {
+		return inline_values;
+	}
+}
+
+sqlite3_value *const *SQLValueRow::values() const {
+	return heap_values ? heap_values.get() : inline_values;
+}
+
+void SQLValueRow::free_values() {
+	sqlite3_value *const *values = this->values();
+	for (int i = 0; i < value_count; i++) {
+		sqlite3_value_free(values[i]);
+	}
+	heap_values.reset();
+	value_count = 0;
+}
+
+}
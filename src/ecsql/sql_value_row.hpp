@@ -0,0 +1,49 @@
+#pragma once
+
+#include <memory>
+#include <span>
+#include <string_view>
+
+#include <sqlite3.h>
+
+#include "sql_base_row.hpp"
+#include "sql_value.hpp"
+
+namespace ecsql {
+
+// Row that owns copies of its values, so it stays valid after the statement or hook that produced it
+struct SQLValueRow : public SQLBaseRow {
+	SQLValueRow() = default;
+	// Copies the old or new row from inside a preupdate hook
+	SQLValueRow(sqlite3 *db, bool use_new_row);
+	// Copies the current row of a statement
+	SQLValueRow(sqlite3_stmt *stmt);
+	SQLValueRow(SQLValueRow&& other);
+	SQLValueRow& operator=(SQLValueRow&& other);
+	~SQLValueRow();
+
+	int column_count() const override;
+
+	SQLValue column_value(int index) const;
+	int column_type(int index) const override;
+
+	bool column_bool(int index) const override;
+	int column_int(int index) const override;
+	sqlite3_int64 column_int64(int index) const override;
+	double column_double(int index) const override;
+	std::string_view column_text(int index) const override;
+	std::span<const uint8_t> column_blob(int index) const override;
+
+protected:
+	// Rows of most components fit inline, so that copying rows from hooks does not allocate
+	static constexpr int INLINE_VALUE_COUNT = 8;
+	sqlite3_value *inline_values[INLINE_VALUE_COUNT];
+	std::unique_ptr<sqlite3_value *[]> heap_values;
+	int value_count = 0;
+
+	sqlite3_value **allocate_values(int count);
+	sqlite3_value *const *values() const;
+	void free_values();
+};
+
+}
@@ -65,6 +65,14 @@ void System::prepare(sqlite3 *db, std::vector<PreparedSQL>& prepared_sql) const
 	for (int i = prepared_sql.size(); i < sql.size(); i++) {
 		prepared_sql.emplace_back(db, sql[i], true);
 	}
+	for (auto [statement_index, column_count] : expected_column_counts) {
+		prepared_sql[statement_index].validate_column_count(column_count);
+	}
+}
+
+void System::prepare(sqlite3 *db, std::vector<PreparedSQL>& prepared_sql, TableAccess& access) const {
+	TableAccess::Recorder recorder(db, access);
+	prepare(db, prepared_sql);
 }
 
 }
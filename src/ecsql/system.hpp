@@ -3,8 +3,11 @@
 #include <functional>
 #include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 #include "prepared_sql.hpp"
+#include "table_access.hpp"
 
 struct sqlite3;
 
@@ -14,6 +17,18 @@ class World;
 class PreparedSQL;
 class SQLRow;
 
+enum class SystemPhase {
+	// Runs inside the frame transaction, in the world connection
+	Simulation,
+	// Same as Simulation, but always in the thread calling `World::update`, e.g. for raylib input or Lua, which are not thread-safe.
+	// With pipelining enabled, these run at the start of the frame, before the other systems are dispatched to a worker thread.
+	MainThread,
+	// Only reads the world, e.g. drawing.
+	// With pipelining enabled, presentation systems render the last committed frame
+	// from a read connection in the main thread, while the next frame is simulated in a worker thread.
+	Presentation,
+};
+
 class System {
 public:
 	System(std::string_view name, std::function<void()> implementation);
@@ -28,10 +43,26 @@ public:
 	void operator()(World& world, std::vector<PreparedSQL>& prepared_sql) const;
 
 	void prepare(sqlite3 *db, std::vector<PreparedSQL>& prepared_sql) const;
+	void prepare(sqlite3 *db, std::vector<PreparedSQL>& prepared_sql, TableAccess& access) const;
+
+	// Validate once, when preparing, that a statement returns the columns read by `get<Types...>`
+	template<typename... Types>
+	System& expect_columns(int statement_index = 0) {
+		expected_column_counts.emplace_back(statement_index, column_count_of_all<Types...>());
+		return *this;
+	}
+
+	System& with_phase(SystemPhase phase) {
+		this->phase = phase;
+		return *this;
+	}
 
 	std::string name;
 	std::vector<std::string> sql;
 	std::function<void(World&, std::vector<PreparedSQL>&)> implementation;
+	SystemPhase phase = SystemPhase::Simulation;
+	// Pairs of statement index and column count
+	std::vector<std::pair<int, int>> expected_column_counts;
 };
 
 }
@@ -0,0 +1,100 @@
+#include <utility>
+
+#include <tracy/Tracy.hpp>
+
+#include "system.hpp"
+#include "system_profiler.hpp"
+
+namespace ecsql {
+
+static const char delete_profiles_sql[] = "DELETE FROM ecsql_profile";
+static const char delete_statement_profiles_sql[] = "DELETE FROM ecsql_profile_statement";
+static const char insert_profile_sql[] = "INSERT INTO ecsql_profile(system, time_ms, vm_steps, fullscan_steps, sorts, autoindexes, runs, culled) VALUES(?, ?, ?, ?, ?, ?, ?, ?)";
+static const char insert_statement_profile_sql[] = "INSERT INTO ecsql_profile_statement(system, statement_index, sql, vm_steps, fullscan_steps, sorts, autoindexes, runs) VALUES(?, ?, ?, ?, ?, ?, ?, ?)";
+
+static thread_local int reported_culled = 0;
+
+void StatementCounters::add(const StatementCounters& other) {
+	vm_steps += other.vm_steps;
+	fullscan_steps += other.fullscan_steps;
+	sorts += other.sorts;
+	autoindexes += other.autoindexes;
+	runs += other.runs;
+}
+
+SystemProfiler::SystemProfiler(sqlite3 *db)
+	: delete_profiles_stmt(db, delete_profiles_sql, true)
+	, delete_statement_profiles_stmt(db, delete_statement_profiles_sql, true)
+	, insert_profile_stmt(db, insert_profile_sql, true)
+	, insert_statement_profile_stmt(db, insert_statement_profile_sql, true)
+{
+}
+
+void SystemProfiler::begin_frame() {
+	profiles.clear();
+	profile_index.clear();
+}
+
+void SystemProfiler::record(const System& system, std::vector<PreparedSQL>& prepared_sql, double time_ms, int culled) {
+	// Fixed delta systems may run more than once per frame, so sum everything by system name
+	auto [it, inserted] = profile_index.try_emplace(system.name, profiles.size());
+	if (inserted) {
+		SystemProfile& profile = profiles.emplace_back();
+		profile.name = system.name;
+		for (PreparedSQL& sql : prepared_sql) {
+			profile.statements.emplace_back(std::string(sql.sql()));
+		}
+	}
+	SystemProfile& profile = profiles[it->second];
+	profile.time_ms += time_ms;
+	profile.culled += culled;
+	for (size_t i = 0; i < prepared_sql.size(); i++) {
+		PreparedSQL& sql = prepared_sql[i];
+		StatementCounters counters {
+			sql.status(SQLITE_STMTSTATUS_VM_STEP, true),
+			sql.status(SQLITE_STMTSTATUS_FULLSCAN_STEP, true),
+			sql.status(SQLITE_STMTSTATUS_SORT, true),
+			sql.status(SQLITE_STMTSTATUS_AUTOINDEX, true),
+			sql.status(SQLITE_STMTSTATUS_RUN, true),
+		};
+		profile.statements[i].counters.add(counters);
+		profile.counters.add(counters);
+	}
+}
+
+void SystemProfiler::publish() {
+	ZoneScoped;
+	delete_profiles_stmt();
+	delete_statement_profiles_stmt();
+	for (const SystemProfile& profile : profiles) {
+		const StatementCounters& counters = profile.counters;
+		insert_profile_stmt(profile.name, profile.time_ms, counters.vm_steps, counters.fullscan_steps, counters.sorts, counters.autoindexes, counters.runs, profile.culled);
+		for (size_t i = 0; i < profile.statements.size(); i++) {
+			const StatementProfile& statement = profile.statements[i];
+			const StatementCounters& counters = statement.counters;
+			insert_statement_profile_stmt(profile.name, (int) i, statement.sql, counters.vm_steps, counters.fullscan_steps, counters.sorts, counters.autoindexes, counters.runs);
+		}
+	}
+}
+
+void SystemProfiler::reset_counters(std::vector<PreparedSQL>& prepared_sql) {
+	for (PreparedSQL& sql : prepared_sql) {
+		for (int op : { SQLITE_STMTSTATUS_VM_STEP, SQLITE_STMTSTATUS_FULLSCAN_STEP, SQLITE_STMTSTATUS_SORT, SQLITE_STMTSTATUS_AUTOINDEX, SQLITE_STMTSTATUS_RUN }) {
+			sql.status(op, true);
+		}
+	}
+}
+
+const std::vector<SystemProfile>& SystemProfiler::get_profiles() const {
+	return profiles;
+}
+
+void SystemProfiler::report_culled(int count) {
+	reported_culled += count;
+}
+
+int SystemProfiler::take_reported_culled() {
+	return std::exchange(reported_culled, 0);
+}
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "prepared_sql.hpp"
+
+typedef struct sqlite3 sqlite3;
+
+namespace ecsql {
+
+class System;
+
+// SQLite VM counters, summed over a frame
+struct StatementCounters {
+	int vm_steps = 0;
+	int fullscan_steps = 0;
+	int sorts = 0;
+	int autoindexes = 0;
+	int runs = 0;
+
+	void add(const StatementCounters& other);
+};
+
+struct StatementProfile {
+	std::string sql;
+	StatementCounters counters;
+};
+
+struct SystemProfile {
+	std::string name;
+	double time_ms = 0;
+	StatementCounters counters;
+	std::vector<StatementProfile> statements;
+	// Rows skipped by view culling, as reported by the system
+	int culled = 0;
+};
+
+// Collects wall time and `sqlite3_stmt_status` counters for each system run in a frame.
+// Results are published into the temporary `ecsql_profile` and `ecsql_profile_statement` tables.
+class SystemProfiler {
+public:
+	SystemProfiler(sqlite3 *db);
+
+	void begin_frame();
+	void record(const System& system, std::vector<PreparedSQL>& prepared_sql, double time_ms, int culled = 0);
+	void publish();
+	// Zero statement counters, so that the first profiled frame doesn't include runs from before profiling
+	static void reset_counters(std::vector<PreparedSQL>& prepared_sql);
+
+	// Called by system implementations while profiling, added to the profile of the system running in this thread
+	static void report_culled(int count);
+	// Culled count reported since the last call, which resets it
+	static int take_reported_culled();
+
+	const std::vector<SystemProfile>& get_profiles() const;
+
+private:
+	std::vector<SystemProfile> profiles;
+	// Keyed by copies of system names, since systems may be registered or removed while a frame is profiled
+	std::unordered_map<std::string, size_t> profile_index;
+	PreparedSQL delete_profiles_stmt;
+	PreparedSQL delete_statement_profiles_stmt;
+	PreparedSQL insert_profile_stmt;
+	PreparedSQL insert_statement_profile_stmt;
+};
+
+}
@@ -0,0 +1,67 @@
+#include <sqlite3.h>
+
+#include "table_access.hpp"
+
+namespace ecsql {
+
+static int record_table_access(void *userdata, int action, const char *arg1, const char *arg2, const char *db_name, const char *trigger_name) {
+	TableAccess& access = *(TableAccess *) userdata;
+	switch (action) {
+		case SQLITE_READ:
+			if (arg1) {
+				access.read_tables.emplace(arg1);
+			}
+			break;
+
+		case SQLITE_INSERT:
+		case SQLITE_UPDATE:
+		case SQLITE_DELETE:
+			if (arg1) {
+				access.write_tables.emplace(arg1);
+			}
+			break;
+
+		case SQLITE_CREATE_INDEX:
+		case SQLITE_CREATE_TABLE:
+		case SQLITE_CREATE_TEMP_INDEX:
+		case SQLITE_CREATE_TEMP_TABLE:
+		case SQLITE_CREATE_TEMP_TRIGGER:
+		case SQLITE_CREATE_TEMP_VIEW:
+		case SQLITE_CREATE_TRIGGER:
+		case SQLITE_CREATE_VIEW:
+		case SQLITE_CREATE_VTABLE:
+		case SQLITE_DROP_INDEX:
+		case SQLITE_DROP_TABLE:
+		case SQLITE_DROP_TEMP_INDEX:
+		case SQLITE_DROP_TEMP_TABLE:
+		case SQLITE_DROP_TEMP_TRIGGER:
+		case SQLITE_DROP_TEMP_VIEW:
+		case SQLITE_DROP_TRIGGER:
+		case SQLITE_DROP_VIEW:
+		case SQLITE_DROP_VTABLE:
+		case SQLITE_ALTER_TABLE:
+		case SQLITE_ATTACH:
+		case SQLITE_DETACH:
+		case SQLITE_TRANSACTION:
+		case SQLITE_SAVEPOINT:
+		case SQLITE_PRAGMA:
+			access.changes_database = true;
+			break;
+
+		default:
+			break;
+	}
+	return SQLITE_OK;
+}
+
+TableAccess::Recorder::Recorder(sqlite3 *db, TableAccess& access)
+	: db(db)
+{
+	sqlite3_set_authorizer(db, record_table_access, &access);
+}
+
+TableAccess::Recorder::~Recorder() {
+	sqlite3_set_authorizer(db, nullptr, nullptr);
+}
+
+}
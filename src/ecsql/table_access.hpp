@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <unordered_set>
+
+typedef struct sqlite3 sqlite3;
+
+namespace ecsql {
+
+// Set of tables read and written by a System, collected with `sqlite3_set_authorizer` while its SQL is prepared.
+// Table names include the ones touched by triggers fired from the system's statements.
+// Used to check that presentation systems only read the world.
+struct TableAccess {
+	std::unordered_set<std::string> read_tables;
+	std::unordered_set<std::string> write_tables;
+	// Statements that change the schema, transactions or pragmas
+	bool changes_database = false;
+
+	// Records table accesses from statements prepared in `db` into `access` while alive.
+	struct Recorder {
+		Recorder(sqlite3 *db, TableAccess& access);
+		~Recorder();
+
+		sqlite3 *db;
+	};
+};
+
+}
@@ -1,9 +1,17 @@
+#include <atomic>
+#include <chrono>
 #include <cstdio>
+#include <cstring>
+#include <format>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
 
 #include "background_system.hpp"
 #include "component.hpp"
 #include "hook_system.hpp"
 #include "prepared_sql.hpp"
+#include "query_plan.hpp"
 #include "sql_hook_row.hpp"
 #include "sql_utility.hpp"
 #include "system.hpp"
@@ -25,15 +33,44 @@ static const char LAST_WORLD_DB_NAME[] = "";
 static const char LAST_SAVE_DB_NAME[] = "";
 #endif
 
+static const int WORLD_BUSY_TIMEOUT_MS = 1000;
+// The world connection runs every system, so it gets a bigger lookaside than the global default
+static const int WORLD_LOOKASIDE_SLOT_SIZE = 256;
+static const int WORLD_LOOKASIDE_SLOT_COUNT = 1024;
+
+// Plain in-memory databases are private to their connection, so use a named memdb database instead,
+// which read connections from the same process can open as well.
+static std::string ecsql_world_db_uri(const char *db_name) {
+	static std::atomic<int> memdb_counter = 0;
+	if (strcmp(db_name, ":memory:") == 0) {
+		return std::format("file:/ecsql-world-{}?vfs=memdb", memdb_counter++);
+	}
+	else {
+		return db_name;
+	}
+}
+
 static sqlite3 *ecsql_create_db(const char *db_name, const char *save_db_name) {
-	std::remove(db_name);
+	bool is_uri = strncmp(db_name, "file:", 5) == 0;
+	if (!is_uri) {
+		std::remove(db_name);
+		std::remove(std::format("{}-wal", db_name).c_str());
+		std::remove(std::format("{}-shm", db_name).c_str());
+	}
 
 	sqlite3 *db;
-	int res = sqlite3_open_v2(db_name, &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL);
+	int res = sqlite3_open_v2(db_name, &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_URI, NULL);
 	if (res != SQLITE_OK) {
 		throw std::runtime_error(sqlite3_errmsg(db));
 	}
+	sqlite3_db_config(db, SQLITE_DBCONFIG_LOOKASIDE, nullptr, WORLD_LOOKASIDE_SLOT_SIZE, WORLD_LOOKASIDE_SLOT_COUNT);
+	sqlite3_busy_timeout(db, WORLD_BUSY_TIMEOUT_MS);
+	if (!is_uri) {
+		// WAL lets read connections work while the world is being written
+		execute_sql_script(db, "PRAGMA journal_mode = WAL");
+	}
 	execute_sql_script(db, world_schema);
+	execute_sql_script(db, Prefab::schema_sql);
 
 	if (save_db_name) {
 		PreparedSQL(db, "ATTACH ? AS save")(save_db_name);
@@ -57,7 +94,8 @@ World::World(const char *world_db_path)
 }
 
 World::World(const char *world_db_path, const char *save_db_path)
-	: db(ecsql_create_db(world_db_path ?: DEFAULT_WORLD_DB_NAME, save_db_path ?: DEFAULT_SAVE_DB_NAME), sqlite3_close_v2)
+	: db_uri(ecsql_world_db_uri(world_db_path ?: DEFAULT_WORLD_DB_NAME))
+	, db(ecsql_create_db(db_uri.c_str(), save_db_path ?: DEFAULT_SAVE_DB_NAME), sqlite3_close_v2)
 	, begin_stmt(db.get(), "BEGIN", true)
 	, commit_stmt(db.get(), "COMMIT", true)
 	, rollback_stmt(db.get(), "ROLLBACK", true)
@@ -68,51 +106,110 @@ World::World(const char *world_db_path, const char *save_db_path)
 	, update_delta_time_stmt(db.get(), time::update_delta_sql, true)
 	, select_fixed_delta_time_stmt(db.get(), time::select_fixed_delta_time_sql, true)
 	, update_fixed_delta_progress_stmt(db.get(), time::update_fixed_delta_progress_sql, true)
+	, readers_block_commits(db_uri.starts_with("file:"))
+	, read_connection_pool(db_uri)
+	, profiler(db.get())
+#if defined(DEBUG) && !defined(NDEBUG)
+	, profiling_enabled(true)
+#else
+	, profiling_enabled(false)
+#endif
 #ifdef __EMSCRIPTEN__
 	, dispatch_queue(0)
 #else
 	, dispatch_queue(2, set_thread_name)
 #endif
 {
+	main_thread_id = std::this_thread::get_id();
 	sqlite3_preupdate_hook(db.get(), preupdate_hook, this);
+	register_connection_setup([this](sqlite3 *db) {
+		change_tracker.register_sql_function(db);
+	});
 }
 
 World::~World() {
+	std::future<bool> world_backup, save_backup;
 	if (LAST_WORLD_DB_NAME[0]) {
-		backup_into(LAST_WORLD_DB_NAME);
+		world_backup = backup_into_async(LAST_WORLD_DB_NAME);
 	}
 	if (LAST_SAVE_DB_NAME[0]) {
-		backup_into(LAST_SAVE_DB_NAME, "save");
+		save_backup = backup_into_async(LAST_SAVE_DB_NAME, "save");
 	}
 	execute_all_prehooks(HookType::OnDelete);
+	if (world_backup.valid()) {
+		world_backup.get();
+	}
+	if (save_backup.valid()) {
+		save_backup.get();
+	}
 }
 
 void World::register_component(const Component& component) {
+	check_world_connection_access();
 	component.prepare(db.get());
+	ecsql::execute_sql_script(db.get(), component.prefab_schema_sql().c_str());
+	prefab_components.emplace_back(component.get_name(), component.instantiate_sql());
+	prefab_component_plans.clear();
+	prepared_sql_cache.clear();
 }
 void World::register_component(Component&& component) {
-	component.prepare(db.get());
+	register_component((const Component&) component);
+}
+
+static void validate_presentation_system(const System& system, const TableAccess& access, bool use_fixed_delta) {
+	if (system.phase != SystemPhase::Presentation) {
+		return;
+	}
+	if (use_fixed_delta) {
+		throw std::runtime_error(std::format("Presentation system '{}' cannot use fixed delta", system.name));
+	}
+	if (!access.write_tables.empty() || access.changes_database) {
+		throw std::runtime_error(std::format("Presentation system '{}' must not write into the world", system.name));
+	}
+}
+
+void World::register_connection_setup(std::function<void(sqlite3 *)> setup) {
+	check_world_connection_access();
+	setup(db.get());
+	read_connection_pool.add_connection_setup(std::move(setup));
+	// The presentation connection is reacquired, so that it runs the new setup too
+	presentation_systems.clear();
+	presentation_connection.reset();
+	is_schedule_dirty = true;
 }
 
 void World::register_system(const System& system, bool use_fixed_delta) {
+	check_world_connection_access();
 	std::vector<PreparedSQL> prepared_sql;
-	system.prepare(db.get(), prepared_sql);
+	TableAccess access;
+	system.prepare(db.get(), prepared_sql, access);
+	validate_presentation_system(system, access, use_fixed_delta);
+	record_query_plan(system);
 	(use_fixed_delta ? fixed_systems : systems).emplace_back(system, std::move(prepared_sql));
+	is_schedule_dirty = true;
 }
 
 void World::register_system(System&& system, bool use_fixed_delta) {
+	check_world_connection_access();
 	std::vector<PreparedSQL> prepared_sql;
-	system.prepare(db.get(), prepared_sql);
+	TableAccess access;
+	system.prepare(db.get(), prepared_sql, access);
+	validate_presentation_system(system, access, use_fixed_delta);
+	record_query_plan(system);
 	(use_fixed_delta ? fixed_systems : systems).emplace_back(std::move(system), std::move(prepared_sql));
+	is_schedule_dirty = true;
 }
 
 void World::remove_system(std::string_view system_name) {
-	std::erase_if(systems, [system_name](std::tuple<System, std::vector<PreparedSQL>> t) {
+	check_world_connection_access();
+	std::erase_if(systems, [system_name](const std::tuple<System, std::vector<PreparedSQL>>& t) {
 		return std::get<0>(t).name == system_name;
 	});
-	std::erase_if(fixed_systems, [system_name](std::tuple<System, std::vector<PreparedSQL>> t) {
+	std::erase_if(fixed_systems, [system_name](const std::tuple<System, std::vector<PreparedSQL>>& t) {
 		return std::get<0>(t).name == system_name;
 	});
+	execute_sql("DELETE FROM ecsql_query_plan WHERE system = ?", system_name);
+	is_schedule_dirty = true;
 }
 
 void World::remove_system(const System& system) {
@@ -120,28 +217,104 @@ void World::remove_system(const System& system) {
 }
 
 void World::remove_systems_with_prefix(std::string_view system_name_prefix) {
-	std::erase_if(systems, [system_name_prefix](std::tuple<System, std::vector<PreparedSQL>> t) {
+	check_world_connection_access();
+	std::erase_if(systems, [system_name_prefix](const std::tuple<System, std::vector<PreparedSQL>>& t) {
 		return std::get<0>(t).name.starts_with(system_name_prefix);
 	});
-	std::erase_if(fixed_systems, [system_name_prefix](std::tuple<System, std::vector<PreparedSQL>> t) {
+	std::erase_if(fixed_systems, [system_name_prefix](const std::tuple<System, std::vector<PreparedSQL>>& t) {
 		return std::get<0>(t).name.starts_with(system_name_prefix);
 	});
+	execute_sql("DELETE FROM ecsql_query_plan WHERE substr(system, 1, length(?1)) = ?1", system_name_prefix);
+	is_schedule_dirty = true;
 }
 
 void World::register_hook_system(const HookSystem& system) {
-	auto it = hook_systems.find(system.component_name);
-	if (it == hook_systems.end()) {
-		it = hook_systems.emplace(system.component_name, std::vector<HookSystem>{}).first;
-	}
-	it->second.push_back(system);
+	check_world_connection_access();
+	hook_systems[intern_table(system.component_name.c_str())].push_back(system);
+	is_schedule_dirty = true;
 }
 
 void World::register_hook_system(HookSystem&& system) {
-	auto it = hook_systems.find(system.component_name);
-	if (it == hook_systems.end()) {
-		it = hook_systems.emplace(system.component_name, std::vector<HookSystem>{}).first;
+	check_world_connection_access();
+	hook_systems[intern_table(system.component_name.c_str())].push_back(std::move(system));
+	is_schedule_dirty = true;
+}
+
+void World::register_hook_system(const BatchedHookSystem& system) {
+	check_world_connection_access();
+	batched_hook_systems[intern_table(system.component_name.c_str())].push_back(system);
+	is_schedule_dirty = true;
+}
+
+void World::register_hook_system(BatchedHookSystem&& system) {
+	check_world_connection_access();
+	batched_hook_systems[intern_table(system.component_name.c_str())].push_back(std::move(system));
+	is_schedule_dirty = true;
+}
+
+void World::flush_hook_batches() {
+	check_world_connection_access();
+	bool is_main_thread = std::this_thread::get_id() == main_thread_id;
+	if (is_main_thread && has_main_thread_hook_changes) {
+		ZoneScopedN("flush_main_thread_hook_batches");
+		has_main_thread_hook_changes = false;
+		for (int table_id = 0; table_id < main_thread_row_hook_changes.size(); table_id++) {
+			if (main_thread_row_hook_changes[table_id].empty()) {
+				continue;
+			}
+			std::vector<HookChange> changes = std::move(main_thread_row_hook_changes[table_id]);
+			main_thread_row_hook_changes[table_id].clear();
+			for (HookChange& change : changes) {
+				for (auto& system : hook_systems[table_id]) {
+					if (system.is_main_thread_only) {
+						system(change.hook, change.old_row, change.new_row);
+					}
+				}
+			}
+		}
+		for (int table_id = 0; table_id < main_thread_hook_changes.size(); table_id++) {
+			if (main_thread_hook_changes[table_id].empty()) {
+				continue;
+			}
+			std::vector<HookChange> changes = std::move(main_thread_hook_changes[table_id]);
+			main_thread_hook_changes[table_id].clear();
+			for (auto& system : batched_hook_systems[table_id]) {
+				if (system.is_main_thread_only) {
+					system(changes);
+				}
+			}
+		}
+	}
+
+	// Batched hooks may write into tables with batched hooks themselves, so keep going until nothing is left
+	while (has_pending_hook_changes) {
+		ZoneScoped;
+		has_pending_hook_changes = false;
+		for (int table_id = 0; table_id < pending_hook_changes.size(); table_id++) {
+			if (pending_hook_changes[table_id].empty()) {
+				continue;
+			}
+			// Swap buffers instead of moving, so that both keep their capacity across frames
+			std::vector<HookChange> changes;
+			changes.swap(hook_changes_buffer);
+			changes.swap(pending_hook_changes[table_id]);
+			bool has_skipped_systems = false;
+			for (auto& system : batched_hook_systems[table_id]) {
+				if (system.is_main_thread_only && !is_main_thread) {
+					has_skipped_systems = true;
+				}
+				else {
+					system(changes);
+				}
+			}
+			if (has_skipped_systems) {
+				std::move(changes.begin(), changes.end(), std::back_inserter(main_thread_hook_changes[table_id]));
+				has_main_thread_hook_changes = true;
+			}
+			changes.clear();
+			hook_changes_buffer.swap(changes);
+		}
 	}
-	it->second.push_back(std::move(system));
 }
 
 void World::register_background_system(const BackgroundSystem& system) {
@@ -169,21 +342,72 @@ void World::remove_background_systems_with_prefix(std::string_view system_name_p
 }
 
 EntityID World::create_entity(std::optional<std::string_view> name, std::optional<EntityID> parent) {
+	check_world_connection_access();
 	create_entity_stmt(name, parent);
 	return sqlite3_last_insert_rowid(db.get());
 }
 
 int World::delete_entity(EntityID id) {
+	check_world_connection_access();
 	delete_entity_stmt(id);
 	return sqlite3_changes(db.get());
 }
 
 int World::delete_entity(std::string_view name) {
+	check_world_connection_access();
 	delete_entity_by_name_stmt(name);
 	return sqlite3_changes(db.get());
 }
 
+ExecutedSQL World::descendants(EntityID id, bool include_self) {
+	return execute_sql(Entity::select_descendants_sql, id, include_self ? 0 : 1);
+}
+
+ExecutedSQL World::ancestors(EntityID id, bool include_self) {
+	return execute_sql(Entity::select_ancestors_sql, id, include_self ? 0 : 1);
+}
+
+bool World::is_descendant(EntityID id, EntityID ancestor_id) {
+	return execute_sql(Entity::is_descendant_sql, ancestor_id, id).get<bool>();
+}
+
+EntityID World::create_prefab_entity(std::optional<std::string_view> name, std::optional<EntityID> parent) {
+	check_world_connection_access();
+	execute_sql(Prefab::insert_sql, name, parent);
+	return sqlite3_last_insert_rowid(db.get());
+}
+
+int World::delete_prefab(std::string_view name) {
+	execute_sql(Prefab::delete_by_name_sql, name);
+	return sqlite3_changes(db.get());
+}
+
+PrefabInstances World::instantiate(std::string_view prefab, int count, std::optional<std::string_view> overrides_json, std::optional<EntityID> parent) {
+	ZoneScoped;
+	PrefabInstances instances;
+	if (count <= 0) {
+		return instances;
+	}
+
+	instances.first_id = execute_sql(Prefab::next_entity_id_sql).get<EntityID>();
+	instances.instance_count = count;
+	execute_sql(Prefab::clear_instances_sql);
+	execute_sql(Prefab::map_instances_sql, prefab, count, instances.first_id, parent, overrides_json);
+	int mapped_entities = sqlite3_changes(db.get());
+	if (mapped_entities == 0) {
+		throw std::runtime_error(std::format("Unknown prefab '{}'", prefab));
+	}
+	instances.entities_per_instance = mapped_entities / count;
+
+	execute_sql(Prefab::instantiate_entities_sql);
+	for (size_t component_index : prefab_component_plan(prefab)) {
+		execute_sql(prefab_components[component_index].second, overrides_json);
+	}
+	return instances;
+}
+
 std::optional<EntityID> World::find_entity(std::string_view name) {
+	check_world_connection_access();
 	if (auto it = find_entity_stmt(name).begin()) {
 		return it.row().get<EntityID>();
 	}
@@ -194,17 +418,26 @@ std::optional<EntityID> World::find_entity(std::string_view name) {
 
 void World::begin_transaction() {
 	ZoneScopedN("begin_transaction");
+	check_world_connection_access();
 	join_previous_commit_or_rollback();
+	// changes recorded outside transactions were committed right away
+	change_tracker.commit();
 	begin_stmt();
 	is_inside_transaction = true;
 }
 
 void World::commit_transaction() {
 	ZoneScoped;
+	check_world_connection_access();
+	flush_hook_batches();
+	change_tracker.commit();
 	join_previous_commit_or_rollback();
+	if (readers_block_commits) {
+		join_background_readers();
+	}
 	commit_or_rollback_result = dispatch_queue.dispatch([this]() {
 		ZoneScopedN("commit_transaction.async");
-		commit_stmt();
+		commit_waiting_for_readers();
 #if defined(DEBUG) && !defined(NDEBUG)
 		for (sqlite3_stmt *stmt = sqlite3_next_stmt(db.get(), nullptr); stmt; stmt = sqlite3_next_stmt(db.get(), stmt)) {
 			if (sqlite3_stmt_busy(stmt)) {
@@ -218,50 +451,243 @@ void World::commit_transaction() {
 
 void World::rollback_transaction() {
 	ZoneScoped;
+	check_world_connection_access();
+	// changes that were rolled back never happened
+	for (auto& changes : pending_hook_changes) {
+		changes.clear();
+	}
+	has_pending_hook_changes = false;
+	for (auto& changes : main_thread_hook_changes) {
+		changes.clear();
+	}
+	for (auto& changes : main_thread_row_hook_changes) {
+		changes.clear();
+	}
+	has_main_thread_hook_changes = false;
+	change_tracker.rollback();
 	join_previous_commit_or_rollback();
 	commit_or_rollback_result = dispatch_queue.dispatch([this]() {
 		ZoneScopedN("rollback_transaction.async");
 		rollback_stmt();
 		is_inside_transaction = false;
+		// Hook systems mirroring rows outside SQL saw writes that never happened
+		for (auto& table_hook_systems : hook_systems) {
+			for (auto& system : table_hook_systems) {
+				if (system.on_rollback) {
+					system.on_rollback(db.get());
+				}
+			}
+		}
 	});
 }
 
 void World::update(float delta_time) {
-	inside_transaction([=](World& self) {
-		{
-			ZoneScopedN("update_delta_time");
-			self.update_delta_time_stmt(delta_time);
-		}
+	if (pipelining_enabled) {
+		update_pipelined(delta_time);
+	}
+	else {
+		update_schedule();
+		simulate(delta_time);
+	}
+}
 
-		// make sure all background systems finished before starting a new frame
-		for (auto&& [system, future] : self.background_systems) {
-			if (system.should_join_before_new_frame() && future.valid()) {
-				future.get();
-			}
+void World::set_pipelining_enabled(bool enabled) {
+#ifndef __EMSCRIPTEN__
+	if (enabled != pipelining_enabled) {
+		pipelining_enabled = enabled;
+		is_schedule_dirty = true;
+	}
+#endif
+}
+
+bool World::is_pipelining_enabled() const {
+	return pipelining_enabled;
+}
+
+void World::simulate(float delta_time) {
+	bool committed = inside_transaction([=](World& self) {
+		self.begin_frame(delta_time);
+		self.run_fixed_update(delta_time, std::nullopt);
+		self.run_systems(self.systems, std::nullopt);
+		self.end_frame();
+	});
+	if (committed) {
+		finish_committed_frame();
+	}
+}
+
+// Runs `f`, rolling back the current transaction on errors, like `inside_transaction`
+template<typename Fn>
+static bool run_or_rollback(World& world, Fn&& f) {
+	try {
+		f();
+		return true;
+	}
+	catch (std::runtime_error& err) {
+		std::cerr << "Runtime error: " << err.what() << std::endl;
+		world.rollback_transaction();
+		return false;
+	}
+}
+
+void World::update_pipelined(float delta_time) {
+	ZoneScoped;
+	// The presentation snapshot must contain the last frame, so wait for its commit.
+	// It must also be taken before the world connection writes, for databases without WAL don't allow new readers after that.
+	join_previous_commit_or_rollback();
+	update_schedule();
+	presentation_connection->begin_read();
+
+	// Main thread systems start the frame transaction, the rest of the frame is simulated in a worker thread
+	bool fixed_update_in_main_thread = has_main_thread_fixed_systems;
+	bool main_thread_succeeded = run_or_rollback(*this, [&]() {
+		begin_transaction();
+		begin_frame(delta_time);
+		record_presentation_profiles();
+		if (fixed_update_in_main_thread) {
+			run_fixed_update(delta_time, std::nullopt);
 		}
+		run_systems(systems, SystemPhase::MainThread);
+	});
 
-		// fixed update
-		float fixed_delta_time = self.select_fixed_delta_time_stmt().get<float>();
-		float fixed_delta_progress = self.fixed_delta_executor.execute(delta_time, fixed_delta_time, [&]() {
-			for (auto&& [system, prepared_sql] : self.fixed_systems) {
-				system(self, prepared_sql);
+	std::future<void> simulation;
+	if (main_thread_succeeded) {
+		is_simulating_async = true;
+		simulation = dispatch_queue.dispatch([=, this]() {
+			ZoneScopedN("simulate.async");
+			bool committed = run_or_rollback(*this, [&]() {
+				if (!fixed_update_in_main_thread) {
+					run_fixed_update(delta_time, SystemPhase::Simulation);
+				}
+				run_systems(systems, SystemPhase::Simulation);
+				end_frame();
+				commit_transaction();
+			});
+			if (committed) {
+				finish_committed_frame();
 			}
 		});
-		self.update_fixed_delta_progress_stmt(fixed_delta_progress);
+	}
 
-		// regular update
-		for (auto&& [system, prepared_sql] : self.systems) {
-			system(self, prepared_sql);
-		}
+	presentation_times.clear();
+	presentation_culled.clear();
+	for (auto&& [system, prepared_sql] : presentation_systems) {
+		auto start = std::chrono::steady_clock::now();
+		system(*this, prepared_sql);
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		presentation_times.push_back(elapsed.count());
+		presentation_culled.push_back(SystemProfiler::take_reported_culled());
+	}
+	// Databases without WAL, like in-memory ones, can only commit after readers are done
+	presentation_connection->end_read();
+	if (simulation.valid()) {
+		simulation.get();
+		is_simulating_async = false;
+	}
 
-		// lastly, dispatch background systems
-		for (auto&& [system, future] : self.background_systems) {
-			if (future.valid()) {
-				future.get();
-			}
-			future = self.dispatch_queue.dispatch([&]() { system(); });
+	// Deliver changes to main thread only hooks
+	flush_hook_batches();
+}
+
+void World::begin_frame(float delta_time) {
+	{
+		ZoneScopedN("update_delta_time");
+		frame++;
+		update_delta_time_stmt(delta_time, (sqlite3_int64) frame);
+	}
+	if (profiling_enabled) {
+		profiler.begin_frame();
+	}
+
+	// make sure all background systems finished before starting a new frame
+	for (auto&& [system, future] : background_systems) {
+		if (system.should_join_before_new_frame() && future.valid()) {
+			future.get();
 		}
+	}
+}
+
+void World::run_fixed_update(float delta_time, std::optional<SystemPhase> phase) {
+	float fixed_delta_time = select_fixed_delta_time_stmt().get<float>();
+	float fixed_delta_progress = fixed_delta_executor.execute(delta_time, fixed_delta_time, [&]() {
+		run_systems(fixed_systems, phase);
 	});
+	update_fixed_delta_progress_stmt(fixed_delta_progress);
+}
+
+void World::end_frame() {
+	if (profiling_enabled) {
+		profiler.publish();
+	}
+}
+
+void World::finish_committed_frame() {
+	change_tracker.compact(frame);
+	// lastly, dispatch background systems, outside the frame transaction
+	dispatch_background_systems();
+}
+
+// Presentation systems from the last update ran while the profiler was busy with the simulation,
+// so they are recorded in the following frame, before it gets published.
+void World::record_presentation_profiles() {
+	if (profiling_enabled && presentation_times.size() == presentation_systems.size()) {
+		for (size_t i = 0; i < presentation_systems.size(); i++) {
+			auto&& [system, prepared_sql] = presentation_systems[i];
+			profiler.record(system, prepared_sql, presentation_times[i], presentation_culled[i]);
+		}
+	}
+	presentation_times.clear();
+	presentation_culled.clear();
+}
+
+uint64_t World::get_frame() const {
+	return frame;
+}
+
+void World::track_changes(std::string_view component_name) {
+	check_world_connection_access();
+	if (change_tracker.find(component_name)) {
+		return;
+	}
+	int entity_id_index = 0;
+	if (auto it = execute_sql("SELECT cid FROM pragma_table_info(?) WHERE name = 'entity_id'", component_name).begin()) {
+		entity_id_index = (*it).get<int>();
+	}
+	int table_id = intern_table(std::string(component_name).c_str());
+	tracked_changes[table_id] = { &change_tracker.track(component_name), entity_id_index };
+}
+
+const ChangeTracker::TableChanges *World::get_changes(std::string_view component_name) const {
+	return change_tracker.find(component_name);
+}
+
+void World::set_profiling_enabled(bool enabled) {
+	check_world_connection_access();
+	if (profiling_enabled && !enabled) {
+		profiler.begin_frame();
+		profiler.publish();
+	}
+	else if (!profiling_enabled && enabled) {
+		for (auto&& [system, prepared_sql] : systems) {
+			SystemProfiler::reset_counters(prepared_sql);
+		}
+		for (auto&& [system, prepared_sql] : fixed_systems) {
+			SystemProfiler::reset_counters(prepared_sql);
+		}
+		for (auto&& [system, prepared_sql] : presentation_systems) {
+			SystemProfiler::reset_counters(prepared_sql);
+		}
+	}
+	profiling_enabled = enabled;
+}
+
+bool World::is_profiling_enabled() const {
+	return profiling_enabled;
+}
+
+const std::vector<SystemProfile>& World::get_system_profiles() const {
+	check_world_connection_access();
+	return profiler.get_profiles();
 }
 
 bool World::backup_into(const char *filename, const char *db_name) {
@@ -275,6 +701,7 @@ bool World::backup_into(const char *filename, const char *db_name) {
 }
 
 bool World::backup_into(sqlite3 *db, const char *db_name) {
+	check_world_connection_access();
 	join_previous_commit_or_rollback();
 	sqlite3_backup *backup = sqlite3_backup_init(db, "main", this->db.get(), db_name);
 	if (!backup) {
@@ -285,6 +712,58 @@ bool World::backup_into(sqlite3 *db, const char *db_name) {
 	return sqlite3_backup_finish(backup) == SQLITE_OK;
 }
 
+std::future<bool> World::backup_into_async(const char *filename, const char *db_name) {
+	ZoneScoped;
+	check_world_connection_access();
+	auto promise = std::make_shared<std::promise<bool>>();
+	std::future<bool> result = promise->get_future();
+
+	SerializedDatabase serialized = serialize(db_name);
+	if (!serialized) {
+		promise->set_value(false);
+		return result;
+	}
+
+	auto shared_serialized = std::make_shared<SerializedDatabase>(std::move(serialized));
+	dispatch_queue.dispatch([promise, shared_serialized, filename = std::string(filename)]() {
+		ZoneScopedN("backup_into_async.write");
+		auto snapshot_db = deserialize_database(std::move(*shared_serialized));
+		if (!snapshot_db) {
+			promise->set_value(false);
+			return;
+		}
+
+		sqlite3 *file_db;
+		if (sqlite3_open_v2(filename.c_str(), &file_db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr) != SQLITE_OK) {
+			std::cerr << "Error backing up into \"" << filename << "\": " << sqlite3_errmsg(file_db) << std::endl;
+			sqlite3_close_v2(file_db);
+			promise->set_value(false);
+			return;
+		}
+		std::unique_ptr<sqlite3, sqlite3_close_v2_deleter> file_db_deleter(file_db);
+		sqlite3_backup *backup = sqlite3_backup_init(file_db, "main", snapshot_db.get(), "main");
+		if (!backup) {
+			std::cerr << "Error backing up db: " << sqlite3_errmsg(file_db) << std::endl;
+			promise->set_value(false);
+			return;
+		}
+		sqlite3_backup_step(backup, -1);
+		promise->set_value(sqlite3_backup_finish(backup) == SQLITE_OK);
+	});
+	return result;
+}
+
+SerializedDatabase World::serialize(const char *db_name) {
+	ZoneScoped;
+	check_world_connection_access();
+	join_previous_commit_or_rollback();
+	return serialize_database(db.get(), db_name);
+}
+
+void World::dispatch_background(std::function<void()> task) {
+	dispatch_queue.dispatch(std::move(task));
+}
+
 bool World::restore_from(const char *filename, const char *db_name) {
 	sqlite3 *db;
 	if (sqlite3_open_v2(filename, &db, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
@@ -295,8 +774,19 @@ bool World::restore_from(const char *filename, const char *db_name) {
 	return restore_from(db, db_name);
 }
 
+bool World::restore_from(SerializedDatabase&& serialized, const char *db_name) {
+	check_world_connection_access();
+	auto db = deserialize_database(std::move(serialized));
+	if (!db) {
+		return false;
+	}
+	return restore_from(db.get(), db_name);
+}
+
 bool World::restore_from(sqlite3 *db, const char *db_name) {
+	check_world_connection_access();
 	join_previous_commit_or_rollback();
+	prepared_sql_cache.clear();
 	sqlite3_backup *backup = sqlite3_backup_init(this->db.get(), db_name, db, "main");
 	if (!backup) {
 		std::cerr << "Error restoring db: " << sqlite3_errmsg(this->db.get()) << std::endl;
@@ -305,18 +795,40 @@ bool World::restore_from(sqlite3 *db, const char *db_name) {
 	execute_all_prehooks(HookType::OnDelete);
 	sqlite3_backup_step(backup, -1);
 	execute_all_prehooks(HookType::OnInsert);
-	return sqlite3_backup_finish(backup) == SQLITE_OK;
+	bool success = sqlite3_backup_finish(backup) == SQLITE_OK;
+	if (strcmp(db_name, "main") == 0) {
+		// keep frames monotonic, so that `Changed` queries still make sense after restoring
+		execute_sql(time::update_frame_sql, (sqlite3_int64) frame);
+	}
+	return success;
 }
 
 std::shared_ptr<sqlite3> World::get_db() const {
 	return db;
 }
 
+ReadConnection World::acquire_read_connection() {
+	return read_connection_pool.acquire();
+}
+
 PreparedSQL World::prepare_sql(std::string_view sql, bool is_persistent) {
+	check_world_connection_access();
 	return PreparedSQL(db.get(), sql, is_persistent);
 }
 
+PreparedSQL World::cached_sql(std::string_view sql) {
+	check_world_connection_access();
+	return prepared_sql_cache.get(db.get(), sql);
+}
+
+const PreparedSQLCache::Stats& World::get_sql_cache_stats() const {
+	return prepared_sql_cache.get_stats();
+}
+
 void World::execute_sql_script(const char *sql) {
+	check_world_connection_access();
+	// Scripts may drop or recreate tables
+	prepared_sql_cache.clear();
 	ecsql::execute_sql_script(db.get(), sql);
 }
 
@@ -331,6 +843,13 @@ void World::preupdate_hook(
 	sqlite3_int64 iKey2           /* New rowid value (for a rowid UPDATE) */
 ) {
 	World *world = (World *) pCtx;
+	if (strcmp(zDb, "prefab") == 0) {
+		world->prefab_component_plans.clear();
+		return;
+	}
+	else if (strcmp(zDb, "temp") == 0) {
+		return;
+	}
 	switch (op) {
 		case SQLITE_INSERT:
 			world->execute_prehook(zName, HookType::OnInsert, iKey1, iKey2);
@@ -346,34 +865,287 @@ void World::preupdate_hook(
 	}
 }
 
+// Components with rows in the prefab mapped in `temp.prefab_instance`
+const std::vector<size_t>& World::prefab_component_plan(std::string_view prefab) {
+	auto it = prefab_component_plans.find(std::string(prefab));
+	if (it != prefab_component_plans.end()) {
+		return it->second;
+	}
+
+	std::vector<size_t> plan;
+	for (size_t i = 0; i < prefab_components.size(); i++) {
+		std::string sql = std::format(
+			"SELECT EXISTS(SELECT 1 FROM temp.prefab_instance JOIN prefab.{0} ON {0}.entity_id = prefab_instance.prefab_entity_id)",
+			prefab_components[i].first
+		);
+		if (execute_sql(sql).get<bool>()) {
+			plan.push_back(i);
+		}
+	}
+	return prefab_component_plans[std::string(prefab)] = std::move(plan);
+}
+
 void World::execute_prehook(const char *table, HookType hook, sqlite3_int64 old_rowid, sqlite3_int64 new_rowid) {
-	auto it = hook_systems.find(table);
-	if (it != hook_systems.end()) {
+	int table_id = intern_table(table);
+	if (tracked_changes[table_id].first) {
 		SQLHookRow old_row { db.get(), old_rowid, false };
 		SQLHookRow new_row { db.get(), new_rowid, true };
-		for (auto& system : it->second) {
-			system(hook, old_row, new_row);
+		record_tracked_change(table_id, hook, old_row, new_row);
+	}
+	if (!batched_hook_systems[table_id].empty()) {
+		pending_hook_changes[table_id].push_back({
+			hook,
+			hook != HookType::OnInsert ? SQLValueRow(db.get(), false) : SQLValueRow(),
+			hook != HookType::OnDelete ? SQLValueRow(db.get(), true) : SQLValueRow(),
+		});
+		has_pending_hook_changes = true;
+	}
+
+	const std::vector<HookSystem>& table_hook_systems = hook_systems[table_id];
+	if (table_hook_systems.empty()) {
+		return;
+	}
+	bool is_main_thread = std::this_thread::get_id() == main_thread_id;
+	bool has_skipped_systems = false;
+	SQLHookRow old_row { db.get(), old_rowid, false };
+	SQLHookRow new_row { db.get(), new_rowid, true };
+	for (auto& system : table_hook_systems) {
+		if (system.is_main_thread_only && !is_main_thread) {
+			has_skipped_systems = true;
+			continue;
 		}
+		system(hook, old_row, new_row);
+	}
+	// preupdate values are gone after the hook returns, so main thread only hooks get copies
+	if (has_skipped_systems) {
+		main_thread_row_hook_changes[table_id].push_back({
+			hook,
+			hook != HookType::OnInsert ? SQLValueRow(db.get(), false) : SQLValueRow(),
+			hook != HookType::OnDelete ? SQLValueRow(db.get(), true) : SQLValueRow(),
+		});
+		has_main_thread_hook_changes = true;
 	}
 }
 
 void World::execute_all_prehooks(HookType hook) {
-	for (auto it : hook_systems) {
+	flush_hook_batches();
+	for (int table_id = 0; table_id < hook_systems.size(); table_id++) {
+		if (!table_has_hooks(table_id) && !tracked_changes[table_id].first) {
+			continue;
+		}
 		std::string sql = "SELECT * FROM ";
-		sql += it.first;
+		sql += hook_table_names[table_id];
 		PreparedSQL select_all(db.get(), sql, false);
+		std::vector<HookChange> changes;
 		for (SQLRow row : select_all()) {
-			for (auto& system : it.second) {
+			if (tracked_changes[table_id].first) {
+				record_tracked_change(table_id, hook, row, row);
+			}
+			for (auto& system : hook_systems[table_id]) {
 				system(hook, row, row);
 			}
+			if (!batched_hook_systems[table_id].empty()) {
+				changes.push_back({
+					hook,
+					hook != HookType::OnInsert ? SQLValueRow(select_all.get_stmt().get()) : SQLValueRow(),
+					hook != HookType::OnDelete ? SQLValueRow(select_all.get_stmt().get()) : SQLValueRow(),
+				});
+			}
+		}
+		for (auto& system : batched_hook_systems[table_id]) {
+			system(changes);
 		}
 	}
 }
 
+int World::intern_table(const char *table) {
+	// SQLite passes the same name pointer for every change in a table, as long as its schema is not reloaded.
+	// Names are compared anyway, in case a pointer gets reused by another table.
+	auto cached = hook_table_id_cache.find(table);
+	if (cached != hook_table_id_cache.end() && hook_table_names[cached->second] == table) {
+		return cached->second;
+	}
+
+	auto [it, inserted] = hook_table_ids.emplace(table, hook_table_names.size());
+	if (inserted) {
+		hook_table_names.emplace_back(table);
+		hook_systems.emplace_back();
+		batched_hook_systems.emplace_back();
+		pending_hook_changes.emplace_back();
+		main_thread_hook_changes.emplace_back();
+		main_thread_row_hook_changes.emplace_back();
+		tracked_changes.emplace_back(nullptr, 0);
+	}
+	// stale pointers pile up after schema reloads, so start over once in a while
+	if (hook_table_id_cache.size() > 4 * hook_table_names.size()) {
+		hook_table_id_cache.clear();
+	}
+	hook_table_id_cache[table] = it->second;
+	return it->second;
+}
+
+void World::record_tracked_change(int table_id, HookType hook, SQLBaseRow& old_row, SQLBaseRow& new_row) {
+	auto [changes, entity_id_index] = tracked_changes[table_id];
+	switch (hook) {
+		case HookType::OnInsert:
+			changes->record(new_row.get<EntityID>(entity_id_index), frame, false);
+			break;
+
+		case HookType::OnUpdate: {
+			EntityID old_entity_id = old_row.get<EntityID>(entity_id_index);
+			EntityID new_entity_id = new_row.get<EntityID>(entity_id_index);
+			if (old_entity_id != new_entity_id) {
+				changes->record(old_entity_id, frame, true);
+			}
+			changes->record(new_entity_id, frame, false);
+			break;
+		}
+
+		case HookType::OnDelete:
+			changes->record(old_row.get<EntityID>(entity_id_index), frame, true);
+			break;
+	}
+}
+
+// With pipelining enabled, the world connection belongs to the simulation worker while a frame is simulated.
+// Presentation systems run in the main thread meanwhile, so they must only use their own statements.
+void World::check_world_connection_access() const {
+	if (is_simulating_async && std::this_thread::get_id() == main_thread_id) {
+		throw std::logic_error("World connection is in use by the simulation, presentation systems must only query their own statements");
+	}
+}
+
+bool World::table_has_hooks(int table_id) const {
+	return !hook_systems[table_id].empty() || !batched_hook_systems[table_id].empty();
+}
+
 void World::join_previous_commit_or_rollback() {
 	if (commit_or_rollback_result.valid()) {
-		commit_or_rollback_result.get();
+		std::shared_future<void> result = std::move(commit_or_rollback_result);
+		result.get();
+	}
+}
+
+void World::commit_waiting_for_readers() {
+	// Databases without WAL, like in-memory ones, only commit after readers are done, e.g. presentation systems.
+	// COMMIT fails with SQLITE_BUSY after the busy timeout and keeps the transaction open, so it is retried.
+	sqlite3_stmt *stmt = commit_stmt.get_stmt().get();
+	int res;
+	while ((res = sqlite3_step(stmt)) == SQLITE_BUSY) {
+		sqlite3_reset(stmt);
+	}
+	sqlite3_reset(stmt);
+	if (res != SQLITE_DONE) {
+		// Never leave the transaction open, or the next frame would fail to begin its own
+		std::cerr << "Commit failed, rolling back: " << sqlite3_errmsg(db.get()) << std::endl;
+		if (!sqlite3_get_autocommit(db.get())) {
+			rollback_stmt();
+		}
+	}
+}
+
+void World::join_background_readers() {
+	for (auto&& [system, future] : background_systems) {
+		if (system.uses_read_connection() && future.valid()) {
+			future.get();
+		}
+	}
+}
+
+void World::dispatch_background_systems() {
+	ZoneScoped;
+	// The commit was dispatched before any of these, so waiting on it cannot starve the queue
+	std::shared_future<void> commit = commit_or_rollback_result;
+	for (auto&& [system, future] : background_systems) {
+		if (future.valid()) {
+			future.get();
+		}
+		future = dispatch_queue.dispatch([this, &system, commit]() {
+			// Read systems open their read transaction only after the frame is committed
+			if (system.uses_read_connection() && commit.valid()) {
+				commit.wait();
+			}
+			system(*this);
+		});
+	}
+}
+
+void World::record_query_plan(const System& system) {
+	ZoneScoped;
+	PreparedSQL insert_step(db.get(), "INSERT INTO ecsql_query_plan(system, statement_index, step_id, parent_id, detail, is_full_scan, is_automatic_index, suggested_index) VALUES(?, ?, ?, ?, ?, ?, ?, ?)");
+	for (int i = 0; i < system.sql.size(); i++) {
+		for (const QueryPlanStep& step : explain_query_plan(db.get(), system.sql[i])) {
+			std::optional<std::string_view> suggested_index;
+			if (!step.suggested_index.empty()) {
+				suggested_index = step.suggested_index;
+			}
+			insert_step(std::string_view(system.name), i, step.id, step.parent_id, std::string_view(step.detail), step.is_full_scan, step.is_automatic_index, suggested_index);
+#if defined(DEBUG) && !defined(NDEBUG)
+			if (step.is_full_scan || step.is_automatic_index) {
+				std::cerr << "[query plan] " << system.name << " #" << i << ": " << step.detail << std::endl;
+				if (suggested_index) {
+					std::cerr << "[query plan]   consider: " << step.suggested_index << std::endl;
+				}
+			}
+#endif
+		}
+	}
+}
+
+void World::update_schedule() {
+	if (!is_schedule_dirty) {
+		return;
+	}
+	ZoneScoped;
+	has_main_thread_fixed_systems = false;
+	for (auto&& [system, prepared_sql] : fixed_systems) {
+		if (system.phase == SystemPhase::MainThread) {
+			has_main_thread_fixed_systems = true;
+			break;
+		}
+	}
+
+	presentation_systems.clear();
+	presentation_times.clear();
+	presentation_culled.clear();
+	if (pipelining_enabled) {
+		if (!presentation_connection) {
+			presentation_connection.emplace(read_connection_pool.acquire());
+		}
+		// Pick up schema changes from the last frame
+		presentation_connection->begin_read();
+		for (auto&& [system, prepared_sql] : systems) {
+			if (system.phase == SystemPhase::Presentation) {
+				auto& [presentation_system, presentation_sql] = presentation_systems.emplace_back(system, std::vector<PreparedSQL>());
+				presentation_system.prepare(presentation_connection->get_db(), presentation_sql);
+			}
+		}
+		presentation_connection->end_read();
+	}
+	else {
+		presentation_connection.reset();
+	}
+	is_schedule_dirty = false;
+}
+
+void World::run_systems(std::vector<std::tuple<System, std::vector<PreparedSQL>>>& systems, std::optional<SystemPhase> phase) {
+	// Systems run in registration order, for they share the same SQLite connection
+	for (auto&& [system, prepared_sql] : systems) {
+		if (phase && system.phase != *phase) {
+			continue;
+		}
+		flush_hook_batches();
+		if (profiling_enabled) {
+			auto start = std::chrono::steady_clock::now();
+			system(*this, prepared_sql);
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+			profiler.record(system, prepared_sql, elapsed.count(), SystemProfiler::take_reported_culled());
+		}
+		else {
+			system(*this, prepared_sql);
+		}
 	}
+	flush_hook_batches();
 }
 
 }
@@ -1,10 +1,15 @@
 #pragma once
 
+#include <atomic>
+#include <deque>
+#include <functional>
 #include <future>
 #include <iostream>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -12,11 +17,18 @@
 #include <sqlite3.h>
 #include <tracy/Tracy.hpp>
 
+#include "batched_hook_system.hpp"
+#include "change_tracker.hpp"
 #include "entity.hpp"
 #include "executed_sql.hpp"
 #include "fixed_delta_executor.hpp"
 #include "hook_system.hpp"
 #include "prepared_sql.hpp"
+#include "prefab.hpp"
+#include "prepared_sql_cache.hpp"
+#include "read_connection_pool.hpp"
+#include "sql_utility.hpp"
+#include "system_profiler.hpp"
 
 namespace ecsql {
 
@@ -24,6 +36,7 @@ class BackgroundSystem;
 class Component;
 class SQLRow;
 class System;
+enum class SystemPhase;
 
 class World {
 public:
@@ -43,6 +56,14 @@ public:
 
 	void register_hook_system(const HookSystem& system);
 	void register_hook_system(HookSystem&& system);
+	void register_hook_system(const BatchedHookSystem& system);
+	void register_hook_system(BatchedHookSystem&& system);
+	// Deliver buffered changes to batched hook systems.
+	// Called automatically around systems and before commits.
+	void flush_hook_batches();
+
+	// Run `setup` in the world connection and in every read connection, e.g. to register SQL functions and virtual tables
+	void register_connection_setup(std::function<void(sqlite3 *)> setup);
 
 	void register_background_system(const BackgroundSystem& system);
 	void register_background_system(BackgroundSystem&& system);
@@ -54,6 +75,19 @@ public:
 	std::optional<EntityID> find_entity(std::string_view name);
 	int delete_entity(EntityID id);
 	int delete_entity(std::string_view name);
+	// Subtree and ancestry lookups from the `entity_closure` table, as `(id, depth)` rows ordered by depth
+	ExecutedSQL descendants(EntityID id, bool include_self = false);
+	ExecutedSQL ancestors(EntityID id, bool include_self = false);
+	bool is_descendant(EntityID id, EntityID ancestor_id);
+
+	// Prefab entities are created in the `prefab` database, with components inserted into `prefab.<Component>`.
+	// Roots are created when `parent` is empty and their name identifies the prefab.
+	EntityID create_prefab_entity(std::optional<std::string_view> name = std::nullopt, std::optional<EntityID> parent = std::nullopt);
+	int delete_prefab(std::string_view name);
+	// Clone a prefab `count` times with a few `INSERT ... SELECT` statements.
+	// `overrides_json` replaces component fields of the roots, e.g. `{"Position": {"x": 10}}` for all instances
+	// or an array with one such object per instance.
+	PrefabInstances instantiate(std::string_view prefab, int count = 1, std::optional<std::string_view> overrides_json = std::nullopt, std::optional<EntityID> parent = std::nullopt);
 
 	template<typename Fn>
 	bool inside_transaction(Fn&& f) {
@@ -79,26 +113,62 @@ public:
 
 	void begin_transaction();
 	void commit_transaction();
+	// Pending batched hook changes are dropped and hook systems with `on_rollback`, like a ComponentCache, restore their state
 	void rollback_transaction();
 
 	void update(float time_delta);
+	// When enabled, `update` runs main thread systems, then simulates the rest of the next frame in a worker thread
+	// while presentation systems render the last committed one in the calling thread.
+	// Presentation profiles are recorded in the following frame, for the profiler is busy during the simulation.
+	// Not available in Emscripten builds, which have no worker threads.
+	void set_pipelining_enabled(bool enabled);
+	bool is_pipelining_enabled() const;
+	// Frame counter, incremented at the start of each `update`. Also available as `time.frame` in SQL.
+	uint64_t get_frame() const;
+
+	// Start tracking changes in a component table, queryable with `Changed(component, since)` in SQL
+	// or with `get_changes(component).since(frame)` in C++
+	void track_changes(std::string_view component_name);
+	const ChangeTracker::TableChanges *get_changes(std::string_view component_name) const;
+
+	// Profiling is enabled by default in debug builds
+	void set_profiling_enabled(bool enabled);
+	bool is_profiling_enabled() const;
+	// Profiles from the last frame, sorted in execution order
+	const std::vector<SystemProfile>& get_system_profiles() const;
 
 	bool backup_into(const char *filename, const char *db_name = "main");
 	bool backup_into(sqlite3 *db, const char *db_name = "main");
+	// Copies the database in memory with `sqlite3_serialize` on the calling thread,
+	// then writes it into `filename` on a worker thread.
+	std::future<bool> backup_into_async(const char *filename, const char *db_name = "main");
+
+	// Consistent copy of a database, cheap when it lives in memory
+	SerializedDatabase serialize(const char *db_name = "main");
+	// Run a task in the world's worker threads, e.g. to write a serialized copy to disk
+	void dispatch_background(std::function<void()> task);
 
 	bool restore_from(const char *filename, const char *db_name = "main");
+	bool restore_from(SerializedDatabase&& serialized, const char *db_name = "main");
 	bool restore_from(sqlite3 *db, const char *db_name = "main");
 
 	std::shared_ptr<sqlite3> get_db() const;
+	// Read-only connection to the world database, safe to use from other threads.
+	// It sees the state from the last committed frame.
+	ReadConnection acquire_read_connection();
 	PreparedSQL prepare_sql(std::string_view sql, bool is_persistent = false);
+	// Statement from the world's LRU cache, prepared only when missing
+	PreparedSQL cached_sql(std::string_view sql);
+	const PreparedSQLCache::Stats& get_sql_cache_stats() const;
 	void execute_sql_script(const char *sql);
 
 	template<typename... Args>
 	ExecutedSQL execute_sql(std::string_view sql, Args&&... args) {
-		return prepare_sql(sql)(std::forward<Args>(args)...);
+		return cached_sql(sql)(std::forward<Args>(args)...);
 	}
 
 private:
+	std::string db_uri;
 	std::shared_ptr<sqlite3> db;
 	PreparedSQL begin_stmt;
 	PreparedSQL commit_stmt;
@@ -111,21 +181,83 @@ private:
 	PreparedSQL select_fixed_delta_time_stmt;
 	PreparedSQL update_fixed_delta_progress_stmt;
 	bool is_inside_transaction = false;
+	// Without WAL, readers hold locks that COMMIT must wait for
+	bool readers_block_commits;
+	ReadConnectionPool read_connection_pool;
+	PreparedSQLCache prepared_sql_cache;
+	SystemProfiler profiler;
+	ChangeTracker change_tracker;
+	uint64_t frame = 0;
+	bool profiling_enabled;
+	bool pipelining_enabled = false;
+	std::atomic<bool> is_simulating_async = false;
+	std::thread::id main_thread_id;
 
 	std::vector<std::tuple<System, std::vector<PreparedSQL>>> systems;
 	std::vector<std::tuple<System, std::vector<PreparedSQL>>> fixed_systems;
-	std::unordered_map<std::string, std::vector<HookSystem>> hook_systems;
+	// With pipelining enabled, the whole fixed update runs in the main thread if any of its systems must
+	bool has_main_thread_fixed_systems = false;
+	// Presentation systems prepared in `presentation_connection`, used when pipelining is enabled
+	std::optional<ReadConnection> presentation_connection;
+	std::vector<std::pair<System, std::vector<PreparedSQL>>> presentation_systems;
+	std::vector<double> presentation_times;
+	std::vector<int> presentation_culled;
+	bool is_schedule_dirty = true;
+	// Hook systems by interned table ID.
+	// Hooks may write into tables not seen before, so interning must not invalidate the hook lists being run.
+	std::deque<std::vector<HookSystem>> hook_systems;
+	std::deque<std::vector<BatchedHookSystem>> batched_hook_systems;
+	std::deque<std::vector<HookChange>> pending_hook_changes;
+	bool has_pending_hook_changes = false;
+	std::vector<HookChange> hook_changes_buffer;
+	// Changes already delivered in a worker thread, still pending for main thread only hooks
+	std::deque<std::vector<HookChange>> main_thread_hook_changes;
+	// Copies of rows changed in a worker thread, pending for main thread only per-row hooks
+	std::deque<std::vector<HookChange>> main_thread_row_hook_changes;
+	bool has_main_thread_hook_changes = false;
+	// Tracked changes and `entity_id` column index by interned table ID, recorded straight from the preupdate hook.
+	// Unlike hook systems, recording runs no user code and needs no copies of the changed rows.
+	std::deque<std::pair<ChangeTracker::TableChanges *, int>> tracked_changes;
+	std::vector<std::string> hook_table_names;
+	std::unordered_map<std::string, int> hook_table_ids;
+	std::unordered_map<const char *, int> hook_table_id_cache;
 	std::vector<std::pair<BackgroundSystem, std::future<void>>> background_systems;
+	// Component name and `instantiate_sql` for each registered component
+	std::vector<std::pair<std::string, std::string>> prefab_components;
+	// Indices into `prefab_components` with rows in each prefab, cleared when the `prefab` database changes
+	std::unordered_map<std::string, std::vector<size_t>> prefab_component_plans;
 
 	dispatch_queue::dispatch_queue dispatch_queue;
-	std::future<void> commit_or_rollback_result;
+	// Shared with background systems that must wait for the frame to be committed
+	std::shared_future<void> commit_or_rollback_result;
 
 	fixed_delta_executor fixed_delta_executor;
 
 	static void preupdate_hook(void *pCtx, sqlite3 *db, int op, char const *zDb, char const *zName, sqlite3_int64 iKey1, sqlite3_int64 iKey2);
 	void execute_prehook(const char *table, HookType hook, sqlite3_int64 old_rowid, sqlite3_int64 new_rowid);
 	void execute_all_prehooks(HookType hook);
+	int intern_table(const char *table);
+	void record_tracked_change(int table_id, HookType hook, SQLBaseRow& old_row, SQLBaseRow& new_row);
+	bool table_has_hooks(int table_id) const;
+	void check_world_connection_access() const;
+	const std::vector<size_t>& prefab_component_plan(std::string_view prefab);
 	void join_previous_commit_or_rollback();
+	void commit_waiting_for_readers();
+	void join_background_readers();
+	void dispatch_background_systems();
+	void record_query_plan(const System& system);
+	void update_schedule();
+	void simulate(float delta_time);
+	void update_pipelined(float delta_time);
+	// Steps of a frame, run inside the frame transaction
+	void begin_frame(float delta_time);
+	void run_fixed_update(float delta_time, std::optional<SystemPhase> phase);
+	void end_frame();
+	// Steps of a frame that run after its commit was dispatched
+	void finish_committed_frame();
+	void record_presentation_profiles();
+	// Runs systems from `phase` only, or all of them when empty
+	void run_systems(std::vector<std::tuple<System, std::vector<PreparedSQL>>>& systems, std::optional<SystemPhase> phase);
 };
 
 }
@@ -2,33 +2,117 @@ PRAGMA foreign_keys = ON;
 PRAGMA synchronous = normal;
 
 -- Entity
+-- AUTOINCREMENT keeps IDs of deleted entities from being reused, since systems may still reference them
 CREATE TABLE entity(
-  id INTEGER PRIMARY KEY,
+  id INTEGER PRIMARY KEY AUTOINCREMENT,
   name TEXT,
   parent_id INTEGER REFERENCES entity(id) ON DELETE CASCADE
 );
 CREATE INDEX entity_name ON entity(name);
 CREATE INDEX entity_parent_id ON entity(parent_id);
 
-CREATE VIEW entity_parents AS
-  WITH RECURSIVE parents(child_id, parent_id) AS (
-    SELECT id, parent_id
-    FROM entity
-    WHERE parent_id IS NOT NULL
+-- Hierarchy closure: one row for each entity and each of its ancestors, plus itself at depth 0.
+-- Kept up to date by the triggers below, so ancestry queries are index lookups.
+CREATE TABLE entity_closure(
+  ancestor_id INTEGER NOT NULL,
+  descendant_id INTEGER NOT NULL,
+  depth INTEGER NOT NULL,
+  PRIMARY KEY(ancestor_id, descendant_id)
+) WITHOUT ROWID;
+CREATE INDEX entity_closure_descendant_id ON entity_closure(descendant_id, depth);
+
+CREATE TRIGGER entity_closure_insert
+AFTER INSERT ON entity
+BEGIN
+  INSERT INTO entity_closure(ancestor_id, descendant_id, depth)
+  SELECT new.id, new.id, 0
+  UNION ALL
+  SELECT ancestor_id, new.id, depth + 1
+  FROM entity_closure
+  WHERE descendant_id = new.parent_id;
+END;
+
+-- Children are deleted by cascade, so the whole subtree goes away
+CREATE TRIGGER entity_closure_delete
+AFTER DELETE ON entity
+BEGIN
+  DELETE FROM entity_closure
+  WHERE descendant_id IN (SELECT descendant_id FROM entity_closure WHERE ancestor_id = old.id);
+END;
 
-    UNION ALL
+-- Parenting an entity to itself or one of its descendants would make a cycle
+CREATE TRIGGER entity_closure_reparent_cycle
+BEFORE UPDATE OF parent_id ON entity
+WHEN new.parent_id IS NOT NULL
+  AND EXISTS(SELECT 1 FROM entity_closure WHERE ancestor_id = new.id AND descendant_id = new.parent_id)
+BEGIN
+  SELECT RAISE(ABORT, 'Entity cannot be parented to itself or one of its descendants');
+END;
 
-    SELECT child_id, entity.parent_id
-    FROM entity JOIN parents ON entity.id = parents.parent_id
-    WHERE entity.parent_id IS NOT NULL
-  )
-  SELECT * FROM parents;
+-- Reparenting detaches the whole subtree from its old ancestors, then links it to the new ones
+CREATE TRIGGER entity_closure_reparent
+AFTER UPDATE OF parent_id ON entity
+WHEN old.parent_id IS NOT new.parent_id
+BEGIN
+  DELETE FROM entity_closure
+  WHERE descendant_id IN (SELECT descendant_id FROM entity_closure WHERE ancestor_id = new.id)
+    AND ancestor_id NOT IN (SELECT descendant_id FROM entity_closure WHERE ancestor_id = new.id);
+
+  INSERT INTO entity_closure(ancestor_id, descendant_id, depth)
+  SELECT ancestors.ancestor_id, subtree.descendant_id, ancestors.depth + subtree.depth + 1
+  FROM entity_closure AS ancestors, entity_closure AS subtree
+  WHERE ancestors.descendant_id = new.parent_id
+    AND subtree.ancestor_id = new.id;
+END;
+
+CREATE VIEW entity_parents AS
+  SELECT descendant_id AS child_id, ancestor_id AS parent_id, depth
+  FROM entity_closure
+  WHERE depth > 0;
 
 -- Time singleton
 CREATE TABLE time(
   delta DEFAULT 0,
   uptime DEFAULT 0,
   fixed_delta DEFAULT (1.0 / 60.0),
-  fixed_delta_progress DEFAULT 0
+  fixed_delta_progress DEFAULT 0,
+  frame DEFAULT 0
 );
 INSERT INTO time DEFAULT VALUES;
+
+-- System profiling, refreshed every frame while profiling is enabled.
+-- Temporary, so that publishing doesn't write to the world database, nor gets saved with it.
+CREATE TEMP TABLE ecsql_profile(
+  system TEXT PRIMARY KEY,
+  time_ms,
+  vm_steps,
+  fullscan_steps,
+  sorts,
+  autoindexes,
+  runs,
+  culled
+);
+CREATE TEMP TABLE ecsql_profile_statement(
+  system TEXT,
+  statement_index,
+  sql TEXT,
+  vm_steps,
+  fullscan_steps,
+  sorts,
+  autoindexes,
+  runs,
+  PRIMARY KEY(system, statement_index)
+);
+
+-- Query plan of each system statement, recorded at registration
+CREATE TABLE ecsql_query_plan(
+  system TEXT,
+  statement_index,
+  step_id,
+  parent_id,
+  detail TEXT,
+  is_full_scan,
+  is_automatic_index,
+  suggested_index TEXT
+);
+CREATE INDEX ecsql_query_plan_system ON ecsql_query_plan(system);
@@ -2,13 +2,14 @@
 
 #include <string>
 #include <string_view>
+#include <type_traits>
 
 #include <reflect>
 #include <flyweight.hpp>
 
 #include "../ecsql/component.hpp"
 #include "../ecsql/sql_base_row.hpp"
-#include "../ecsql/hook_system.hpp"
+#include "../ecsql/batched_hook_system.hpp"
 
 using namespace ecsql;
 
@@ -36,7 +37,15 @@ struct ComponentFlyweight {
 
 	template<typename U>
 	flyweight::flyweight_refcounted<Key, T>::autorelease_value_type get(U&& key) {
-		return flyweight.get_autorelease(Key(std::forward<U>(key)));
+		if constexpr (std::is_same_v<Key, std::string>) {
+			// Draw systems look up flyweights for every entity each frame, so reuse the key's memory
+			thread_local std::string key_buffer;
+			key_buffer.assign(std::forward<U>(key));
+			return flyweight.get_autorelease(key_buffer);
+		}
+		else {
+			return flyweight.get_autorelease(Key(std::forward<U>(key)));
+		}
 	}
 
 	template<typename U>
@@ -52,15 +61,19 @@ struct ComponentFlyweight {
 	flyweight::flyweight_refcounted<Key, T> flyweight;
 	Component component;
 
-	HookSystem hook_system {
+	BatchedHookSystem hook_system {
 		component,
-		[this](HookType hook, SQLBaseRow& old_row, SQLBaseRow& new_row) {
-			if (hook == ecsql::HookType::OnInsert || hook == ecsql::HookType::OnUpdate) {
-				flyweight.get(new_row.get<std::string>(component.first_field_index()));
+		[this](std::span<const HookChange> changes) {
+			for (const HookChange& change : changes) {
+				if (change.hook == ecsql::HookType::OnInsert || change.hook == ecsql::HookType::OnUpdate) {
+					flyweight.get(change.new_row.get<std::string>(component.first_field_index()));
+				}
+				if (change.hook == ecsql::HookType::OnDelete || change.hook == ecsql::HookType::OnUpdate) {
+					flyweight.release(change.old_row.get<std::string>(component.first_field_index()));
+				}
 			}
-			if (hook == ecsql::HookType::OnDelete || hook == ecsql::HookType::OnUpdate) {
-				flyweight.release(old_row.get<std::string>(component.first_field_index()));
-			}
-		}
+		},
+		// flyweights hold GPU resources, which must be loaded in the graphics thread
+		true,
 	};
 };
@@ -33,3 +33,11 @@ CREATE TABLE input_action_axis(
   action_negative,
   value
 );
+
+-- Spatial index with the bounds of entities with Position or Rectangle.
+-- Kept in sync once per frame by the UpdateSpatialIndex system.
+CREATE VIRTUAL TABLE entity_bounds USING rtree(
+  entity_id,
+  min_x, max_x,
+  min_y, max_y
+);
@@ -18,6 +18,7 @@
 #include "screen.hpp"
 #include "sqlite_functions.hpp"
 #include "ecsql/additional_sql.hpp"
+#include "ecsql/batched_hook_system.hpp"
 #include "ecsql/component.hpp"
 #include "ecsql/hook_system.hpp"
 #include "ecsql/world.hpp"
@@ -26,6 +27,7 @@
 #include "scripting/lua_scripting.hpp"
 #include "systems/draw_systems.hpp"
 #include "systems/key_handler.hpp"
+#include "systems/spatial_index.hpp"
 #include "systems/yoga.hpp"
 
 static void log_function(void *, int error, const char *message) {
@@ -90,9 +92,10 @@ int game_main(int argc, const char **argv) {
 	InitWindow(800, 600, exe_file_name);
 
 	ecsql::World world(getenv("ECSQL_DB"));
+	world.set_pipelining_enabled(getenv("ECSQL_PIPELINED") != nullptr);
 	world.execute_sql_script(game_schema);
 	on_window_resized(world, GetScreenWidth(), GetScreenHeight());
-	register_sqlite_functions(world.get_db().get());
+	world.register_connection_setup(register_sqlite_functions);
 
 	// Components
 	ecsql::Component::foreach_static_linked_list([&](ecsql::Component *component) {
@@ -101,6 +104,9 @@ int game_main(int argc, const char **argv) {
 	ecsql::HookSystem::foreach_static_linked_list([&](ecsql::HookSystem *system) {
 		world.register_hook_system(*system);
 	});
+	ecsql::BatchedHookSystem::foreach_static_linked_list([&](ecsql::BatchedHookSystem *system) {
+		world.register_hook_system(*system);
+	});
 	ecsql::AdditionalSQL::foreach_static_linked_list([&](ecsql::AdditionalSQL *additional_sql) {
 		world.execute_sql_script(additional_sql->get_sql().c_str());
 	});
@@ -108,6 +114,7 @@ int game_main(int argc, const char **argv) {
 	// Systems
 	register_key_handler(world);
 	register_update_yoga(world);
+	register_spatial_index(world);
 	register_draw_systems(world);
 
 	// Other engine features, must be created after world components are registered
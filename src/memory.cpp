@@ -1,63 +1,55 @@
-#include "memory.hpp"
-
-lua_Alloc lua_allocf = nullptr;
-
-#ifdef TRACY_ENABLE
+#include <atomic>
 #include <cstdlib>
+#include <new>
 
 #include <box2d/box2d.h>
 #include <physfs.h>
 #include <sqlite3.h>
 #include <tracy/Tracy.hpp>
 
-// Global operator new/delete
+#include "memory.hpp"
+#include "size_class_pool.hpp"
+
+lua_Alloc lua_allocf = nullptr;
+
+// SQLite page cache and lookaside slots.
+// Pages that don't fit the page cache overflow into the heap, check `MemoryStats` when tuning these.
+static const int SQLITE_PAGE_SIZE = 4096;
+static const int SQLITE_PAGECACHE_SLOTS = 2048;
+static const int SQLITE_LOOKASIDE_SLOT_SIZE = 256;
+static const int SQLITE_LOOKASIDE_SLOT_COUNT = 256;
+
+// Global operator new/delete, counting allocations to catch regressions in steady-state frames
+static std::atomic<uint64_t> allocation_count = 0;
+
 void *operator new(std::size_t n) {
 	void *ptr = malloc(n);
+	if (!ptr) {
+		throw std::bad_alloc();
+	}
+	allocation_count.fetch_add(1, std::memory_order_relaxed);
 	TracyAlloc(ptr, n);
 	return ptr;
 }
 
+void *operator new[](std::size_t n) {
+	return operator new(n);
+}
+
 void operator delete(void * p) noexcept {
 	TracyFree(p);
 	free(p);
 }
 
-// Box2D memory allocator
-const char *BOX2D_MEMORY_ZONE_NAME = "box2d";
-static void *box2d_alloc(unsigned int size, int alignment) {
-	void *ptr = std::aligned_alloc(alignment, size);
-	TracyAllocN(ptr, size, BOX2D_MEMORY_ZONE_NAME);
-	return ptr;
-}
-
-static void box2d_free(void *ptr) {
-	TracyFreeN(ptr, BOX2D_MEMORY_ZONE_NAME);
-	free(ptr);
+void operator delete[](void * p) noexcept {
+	operator delete(p);
 }
 
-static void configure_box2d_allocator() {
-	b2SetAllocator(box2d_alloc, box2d_free);
+uint64_t get_allocation_count() {
+	return allocation_count.load(std::memory_order_relaxed);
 }
 
-// Lua memory allocator
-const char *LUA_MEMORY_ZONE_NAME = "lua";
-void *lua_alloc(void *ud, void *ptr, size_t osize, size_t nsize) {
-	if (nsize == 0) {
-		if (ptr) {
-			TracyFreeN(ptr, LUA_MEMORY_ZONE_NAME);
-			free(ptr);
-		}
-		return nullptr;
-	}
-	else {
-		if (ptr) {
-			TracyFreeN(ptr, LUA_MEMORY_ZONE_NAME);
-		}
-		ptr = realloc(ptr, nsize);
-		TracyAllocN(ptr, nsize, LUA_MEMORY_ZONE_NAME);
-		return ptr;
-	}
-}
+#ifdef TRACY_ENABLE
 
 // SQLite memory allocations
 const char *SQLITE_MEMORY_ZONE_NAME = "sqlite3";
@@ -128,12 +120,111 @@ static void configure_physfs_allocator() {
 }
 #endif // TRACY_ENABLE
 
+// Box2D memory allocator
+// Allocations are only counted, not pooled: Box2D already keeps its bodies, shapes and contacts
+// in growable arrays and uses its own stack arena while stepping, so what reaches this allocator
+// is mostly array growth, which a small block pool would not serve. Its free function also
+// receives no size, so pooled blocks would need headers too.
+const char *BOX2D_MEMORY_ZONE_NAME = "box2d";
+static std::atomic<uint64_t> box2d_allocations = 0;
+static std::atomic<uint64_t> box2d_live_allocations = 0;
+
+static void *box2d_alloc(unsigned int size, int alignment) {
+	void *ptr = std::aligned_alloc(alignment, size);
+	TracyAllocN(ptr, size, BOX2D_MEMORY_ZONE_NAME);
+	box2d_allocations++;
+	box2d_live_allocations++;
+	return ptr;
+}
+
+static void box2d_free(void *ptr) {
+	TracyFreeN(ptr, BOX2D_MEMORY_ZONE_NAME);
+	box2d_live_allocations--;
+	free(ptr);
+}
+
+static void configure_box2d_allocator() {
+	b2SetAllocator(box2d_alloc, box2d_free);
+}
+
+// Lua memory allocator
+// Most Lua allocations are small strings, tables and closures, which are served by a size class pool
+const char *LUA_MEMORY_ZONE_NAME = "lua";
+static SizeClassPool lua_pool;
+
+static void *lua_alloc(void *ud, void *ptr, size_t osize, size_t nsize) {
+	if (!ptr) {
+		// `osize` is the object type for new blocks
+		osize = 0;
+	}
+	if (nsize == 0) {
+		if (ptr) {
+			TracyFreeN(ptr, LUA_MEMORY_ZONE_NAME);
+			lua_pool.deallocate(ptr, osize);
+		}
+		return nullptr;
+	}
+	else {
+		if (ptr) {
+			TracyFreeN(ptr, LUA_MEMORY_ZONE_NAME);
+		}
+		ptr = lua_pool.reallocate(ptr, osize, nsize);
+		TracyAllocN(ptr, nsize, LUA_MEMORY_ZONE_NAME);
+		return ptr;
+	}
+}
+
+// SQLite memory configuration, must happen before SQLite is initialized
+static void configure_sqlite_memory() {
+	int header_size = 0;
+	sqlite3_config(SQLITE_CONFIG_PCACHE_HDRSZ, &header_size);
+	int slot_size = SQLITE_PAGE_SIZE + header_size;
+	static void *pagecache = malloc((size_t) slot_size * SQLITE_PAGECACHE_SLOTS);
+	sqlite3_config(SQLITE_CONFIG_PAGECACHE, pagecache, slot_size, SQLITE_PAGECACHE_SLOTS);
+	sqlite3_config(SQLITE_CONFIG_LOOKASIDE, SQLITE_LOOKASIDE_SLOT_SIZE, SQLITE_LOOKASIDE_SLOT_COUNT);
+}
 
 void configure_memory_hooks() {
-#ifdef TRACY_ENABLE
+	configure_sqlite_memory();
 	configure_box2d_allocator();
+	lua_allocf = lua_alloc;
+#ifdef TRACY_ENABLE
 	configure_sqlite_memory_methods();
 	configure_physfs_allocator();
-	lua_allocf = lua_alloc;
 #endif
 }
+
+MemoryStats get_memory_stats(sqlite3 *db) {
+	MemoryStats stats;
+	int current, highwater;
+	sqlite3_status(SQLITE_STATUS_PAGECACHE_USED, &current, &highwater, false);
+	stats.pagecache_used = current;
+	stats.pagecache_highwater = highwater;
+	stats.pagecache_slots = SQLITE_PAGECACHE_SLOTS;
+	sqlite3_status(SQLITE_STATUS_PAGECACHE_OVERFLOW, &current, &highwater, false);
+	stats.pagecache_overflow_bytes = current;
+
+	if (db) {
+		sqlite3_db_status(db, SQLITE_DBSTATUS_LOOKASIDE_USED, &current, &highwater, false);
+		stats.lookaside_used = current;
+		sqlite3_db_status(db, SQLITE_DBSTATUS_LOOKASIDE_HIT, &current, &highwater, false);
+		stats.lookaside_hits = highwater;
+		sqlite3_db_status(db, SQLITE_DBSTATUS_LOOKASIDE_MISS_SIZE, &current, &highwater, false);
+		stats.lookaside_misses_size = highwater;
+		sqlite3_db_status(db, SQLITE_DBSTATUS_LOOKASIDE_MISS_FULL, &current, &highwater, false);
+		stats.lookaside_misses_full = highwater;
+		sqlite3_db_status(db, SQLITE_DBSTATUS_CACHE_HIT, &current, &highwater, false);
+		stats.cache_hits = current;
+		sqlite3_db_status(db, SQLITE_DBSTATUS_CACHE_MISS, &current, &highwater, false);
+		stats.cache_misses = current;
+	}
+
+	const SizeClassPool::Stats& lua_stats = lua_pool.get_stats();
+	stats.lua_pool_allocations = lua_stats.pool_allocations;
+	stats.lua_fallback_allocations = lua_stats.fallback_allocations;
+	stats.lua_pool_bytes = lua_stats.chunk_bytes;
+
+	stats.box2d_allocations = box2d_allocations;
+	stats.box2d_live_allocations = box2d_live_allocations;
+	return stats;
+}
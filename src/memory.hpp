@@ -1,7 +1,37 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+
 #include <lua.h>
+#include <sqlite3.h>
 
 extern lua_Alloc lua_allocf;
 
+// Allocation counters, for tuning the memory configuration
+struct MemoryStats {
+	// SQLite page cache slots, shared by all connections
+	int pagecache_used = 0;
+	int pagecache_highwater = 0;
+	int pagecache_slots = 0;
+	int pagecache_overflow_bytes = 0;
+	// Per connection lookaside and page cache
+	int lookaside_used = 0;
+	int lookaside_hits = 0;
+	int lookaside_misses_size = 0;
+	int lookaside_misses_full = 0;
+	int cache_hits = 0;
+	int cache_misses = 0;
+	// Lua size class pool
+	uint64_t lua_pool_allocations = 0;
+	uint64_t lua_fallback_allocations = 0;
+	size_t lua_pool_bytes = 0;
+	// Box2D
+	uint64_t box2d_allocations = 0;
+	uint64_t box2d_live_allocations = 0;
+};
+
 void configure_memory_hooks();
+// Number of `operator new` calls so far, in all threads
+uint64_t get_allocation_count();
+MemoryStats get_memory_stats(sqlite3 *db);
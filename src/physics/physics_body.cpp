@@ -3,6 +3,7 @@
 #include <raylib.h>
 
 #include "physics_body.hpp"
+#include "physics_body_state.hpp"
 #include "box2d/math_functions.h"
 #include "physics_world.hpp"
 #include "../ecsql/system.hpp"
@@ -40,32 +41,35 @@ ecsql::Component BodyComponent {
 	}
 };
 
-ecsql::HookSystem BodyHookSystem {
+ecsql::BatchedHookSystem BodyHookSystem {
 	BodyComponent,
-	[](ecsql::HookType hook, ecsql::SQLBaseRow& old_row, ecsql::SQLBaseRow& new_row) {
-		switch (hook) {
-			case ecsql::HookType::OnInsert:
-				pending_create_body.push_back(new_row.get<ecsql::EntityID>(0));
-				break;
+	[](std::span<const ecsql::HookChange> changes) {
+		for (const ecsql::HookChange& change : changes) {
+			switch (change.hook) {
+				case ecsql::HookType::OnInsert:
+					pending_create_body.push_back(change.new_row.get<ecsql::EntityID>(0));
+					break;
 
-			case ecsql::HookType::OnUpdate:
-				break;
+				case ecsql::HookType::OnUpdate:
+					break;
 
-			case ecsql::HookType::OnDelete: {
-				auto it = body_map.find(old_row.get<ecsql::EntityID>(0));
-				if (it != body_map.end()) {
-					if (b2Body_IsValid(it->second)) {
-						b2DestroyBody(it->second);
+				case ecsql::HookType::OnDelete: {
+					auto it = body_map.find(change.old_row.get<ecsql::EntityID>(0));
+					if (it != body_map.end()) {
+						if (b2Body_IsValid(it->second)) {
+							b2DestroyBody(it->second);
+						}
+						body_map.erase(it);
 					}
-					body_map.erase(it);
+					break;
 				}
-				break;
 			}
 		}
 	},
 };
 
 void register_physics_body(ecsql::World& world) {
+	world.register_connection_setup(register_physics_body_state);
 	world.register_system({
 		"physics.CreateBody",
 		{
@@ -0,0 +1,217 @@
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include <raylib.h>
+#include <sqlite3.h>
+
+#include "physics_body.hpp"
+#include "physics_body_state.hpp"
+
+enum PhysicsBodyStateColumn {
+	COLUMN_ENTITY_ID,
+	COLUMN_X,
+	COLUMN_Y,
+	COLUMN_ROTATION,
+	COLUMN_LINEAR_VELOCITY_X,
+	COLUMN_LINEAR_VELOCITY_Y,
+	COLUMN_ANGULAR_VELOCITY,
+};
+
+enum PhysicsBodyStateIndex {
+	INDEX_FULL_SCAN,
+	INDEX_ENTITY_ID,
+};
+
+// Values read from this table come back as doubles in degrees, so allow for float round trip errors
+static bool changed(float value, float new_value) {
+	return std::fabs(new_value - value) > 1e-5f;
+}
+
+struct physics_body_state_cursor : public sqlite3_vtab_cursor {
+	// Bodies may be created or destroyed while iterating, so the scan iterates over a copy of the entity IDs
+	std::vector<std::pair<ecsql::EntityID, b2BodyId>> bodies;
+	size_t index;
+};
+
+static int physics_body_state_connect(sqlite3 *db, void *aux, int argc, const char *const *argv, sqlite3_vtab **out_vtab, char **out_error) {
+	int res = sqlite3_declare_vtab(db, "CREATE TABLE x(entity_id INTEGER PRIMARY KEY, x, y, rotation, linear_velocity_x, linear_velocity_y, angular_velocity)");
+	if (res != SQLITE_OK) {
+		return res;
+	}
+	sqlite3_vtab *vtab = (sqlite3_vtab *) sqlite3_malloc(sizeof(sqlite3_vtab));
+	if (!vtab) {
+		return SQLITE_NOMEM;
+	}
+	memset(vtab, 0, sizeof(sqlite3_vtab));
+	*out_vtab = vtab;
+	return SQLITE_OK;
+}
+
+static int physics_body_state_disconnect(sqlite3_vtab *vtab) {
+	sqlite3_free(vtab);
+	return SQLITE_OK;
+}
+
+static int physics_body_state_best_index(sqlite3_vtab *vtab, sqlite3_index_info *index_info) {
+	for (int i = 0; i < index_info->nConstraint; i++) {
+		const auto& constraint = index_info->aConstraint[i];
+		if (constraint.usable && constraint.iColumn == COLUMN_ENTITY_ID && constraint.op == SQLITE_INDEX_CONSTRAINT_EQ) {
+			index_info->aConstraintUsage[i].argvIndex = 1;
+			index_info->aConstraintUsage[i].omit = 1;
+			index_info->idxNum = INDEX_ENTITY_ID;
+			index_info->idxFlags = SQLITE_INDEX_SCAN_UNIQUE;
+			index_info->estimatedCost = 1;
+			index_info->estimatedRows = 1;
+			return SQLITE_OK;
+		}
+	}
+	index_info->idxNum = INDEX_FULL_SCAN;
+	index_info->estimatedCost = body_map.size();
+	index_info->estimatedRows = body_map.size();
+	return SQLITE_OK;
+}
+
+static int physics_body_state_open(sqlite3_vtab *vtab, sqlite3_vtab_cursor **out_cursor) {
+	*out_cursor = new physics_body_state_cursor();
+	return SQLITE_OK;
+}
+
+static int physics_body_state_close(sqlite3_vtab_cursor *cursor) {
+	delete (physics_body_state_cursor *) cursor;
+	return SQLITE_OK;
+}
+
+static int physics_body_state_filter(sqlite3_vtab_cursor *base_cursor, int index_num, const char *index_str, int argc, sqlite3_value **argv) {
+	physics_body_state_cursor *cursor = (physics_body_state_cursor *) base_cursor;
+	cursor->bodies.clear();
+	cursor->index = 0;
+	if (index_num == INDEX_ENTITY_ID) {
+		auto it = body_map.find(sqlite3_value_int64(argv[0]));
+		if (it != body_map.end()) {
+			cursor->bodies.push_back(*it);
+		}
+	}
+	else {
+		cursor->bodies.assign(body_map.begin(), body_map.end());
+	}
+	return SQLITE_OK;
+}
+
+static int physics_body_state_next(sqlite3_vtab_cursor *cursor) {
+	((physics_body_state_cursor *) cursor)->index++;
+	return SQLITE_OK;
+}
+
+static int physics_body_state_eof(sqlite3_vtab_cursor *base_cursor) {
+	physics_body_state_cursor *cursor = (physics_body_state_cursor *) base_cursor;
+	return cursor->index >= cursor->bodies.size();
+}
+
+static int physics_body_state_column(sqlite3_vtab_cursor *base_cursor, sqlite3_context *ctx, int column) {
+	physics_body_state_cursor *cursor = (physics_body_state_cursor *) base_cursor;
+	auto [entity_id, body_id] = cursor->bodies[cursor->index];
+	if (column != COLUMN_ENTITY_ID && !b2Body_IsValid(body_id)) {
+		return SQLITE_OK;
+	}
+	switch (column) {
+		case COLUMN_ENTITY_ID:
+			sqlite3_result_int64(ctx, entity_id);
+			break;
+
+		case COLUMN_X:
+			sqlite3_result_double(ctx, b2Body_GetPosition(body_id).x);
+			break;
+
+		case COLUMN_Y:
+			sqlite3_result_double(ctx, b2Body_GetPosition(body_id).y);
+			break;
+
+		case COLUMN_ROTATION:
+			sqlite3_result_double(ctx, b2Rot_GetAngle(b2Body_GetRotation(body_id)) * RAD2DEG);
+			break;
+
+		case COLUMN_LINEAR_VELOCITY_X:
+			sqlite3_result_double(ctx, b2Body_GetLinearVelocity(body_id).x);
+			break;
+
+		case COLUMN_LINEAR_VELOCITY_Y:
+			sqlite3_result_double(ctx, b2Body_GetLinearVelocity(body_id).y);
+			break;
+
+		case COLUMN_ANGULAR_VELOCITY:
+			sqlite3_result_double(ctx, b2Body_GetAngularVelocity(body_id) * RAD2DEG);
+			break;
+	}
+	return SQLITE_OK;
+}
+
+static int physics_body_state_rowid(sqlite3_vtab_cursor *base_cursor, sqlite3_int64 *out_rowid) {
+	physics_body_state_cursor *cursor = (physics_body_state_cursor *) base_cursor;
+	*out_rowid = cursor->bodies[cursor->index].first;
+	return SQLITE_OK;
+}
+
+static int physics_body_state_update(sqlite3_vtab *vtab, int argc, sqlite3_value **argv, sqlite3_int64 *out_rowid) {
+	bool is_update = argc > 1 && sqlite3_value_type(argv[0]) != SQLITE_NULL;
+	if (!is_update) {
+		sqlite3_free(vtab->zErrMsg);
+		vtab->zErrMsg = sqlite3_mprintf("PhysicsBodyState only supports UPDATE, use the Body component to create or destroy bodies");
+		return SQLITE_CONSTRAINT_VTAB;
+	}
+
+	auto it = body_map.find(sqlite3_value_int64(argv[0]));
+	if (it == body_map.end() || !b2Body_IsValid(it->second)) {
+		return SQLITE_OK;
+	}
+	b2BodyId body_id = it->second;
+	sqlite3_value **columns = argv + 2;
+
+	// Only touch Box2D for changed values, setting the transform or velocities wakes up the body
+	b2Vec2 position = b2Body_GetPosition(body_id);
+	b2Rot rotation = b2Body_GetRotation(body_id);
+	b2Vec2 new_position = {
+		(float) sqlite3_value_double(columns[COLUMN_X]),
+		(float) sqlite3_value_double(columns[COLUMN_Y]),
+	};
+	float new_angle = sqlite3_value_double(columns[COLUMN_ROTATION]) * DEG2RAD;
+	if (changed(position.x, new_position.x) || changed(position.y, new_position.y) || changed(b2Rot_GetAngle(rotation), new_angle)) {
+		b2Body_SetTransform(body_id, new_position, b2MakeRot(new_angle));
+	}
+
+	b2Vec2 linear_velocity = b2Body_GetLinearVelocity(body_id);
+	b2Vec2 new_linear_velocity = {
+		(float) sqlite3_value_double(columns[COLUMN_LINEAR_VELOCITY_X]),
+		(float) sqlite3_value_double(columns[COLUMN_LINEAR_VELOCITY_Y]),
+	};
+	if (changed(linear_velocity.x, new_linear_velocity.x) || changed(linear_velocity.y, new_linear_velocity.y)) {
+		b2Body_SetLinearVelocity(body_id, new_linear_velocity);
+	}
+
+	float new_angular_velocity = sqlite3_value_double(columns[COLUMN_ANGULAR_VELOCITY]) * DEG2RAD;
+	if (changed(b2Body_GetAngularVelocity(body_id), new_angular_velocity)) {
+		b2Body_SetAngularVelocity(body_id, new_angular_velocity);
+	}
+	return SQLITE_OK;
+}
+
+static sqlite3_module physics_body_state_module = {
+	0,                               // iVersion
+	nullptr,                         // xCreate: eponymous-only
+	physics_body_state_connect,      // xConnect
+	physics_body_state_best_index,   // xBestIndex
+	physics_body_state_disconnect,   // xDisconnect
+	nullptr,                         // xDestroy
+	physics_body_state_open,         // xOpen
+	physics_body_state_close,        // xClose
+	physics_body_state_filter,       // xFilter
+	physics_body_state_next,         // xNext
+	physics_body_state_eof,          // xEof
+	physics_body_state_column,       // xColumn
+	physics_body_state_rowid,        // xRowid
+	physics_body_state_update,       // xUpdate
+};
+
+void register_physics_body_state(sqlite3 *db) {
+	sqlite3_create_module(db, "PhysicsBodyState", &physics_body_state_module, nullptr);
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+typedef struct sqlite3 sqlite3;
+
+// Eponymous virtual table "PhysicsBodyState", reading live body state from Box2D on demand.
+// Columns: entity_id, x, y, rotation, linear_velocity_x, linear_velocity_y, angular_velocity.
+// Updating rows sets the body transform and velocities. Inserts and deletes are not supported,
+// create and destroy bodies through the Body component instead.
+// Box2D is not thread-safe: with pipelining enabled, read connections may only query it
+// while the simulation is not stepping, e.g. from main thread or presentation systems.
+void register_physics_body_state(sqlite3 *db);
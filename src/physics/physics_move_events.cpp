@@ -0,0 +1,161 @@
+#include <cstring>
+
+#include <raylib.h>
+#include <sqlite3.h>
+
+#include "physics_body.hpp"
+#include "physics_move_events.hpp"
+
+static std::span<const b2BodyMoveEvent> current_move_events;
+
+enum PhysicsMovesColumn {
+	COLUMN_ENTITY_ID,
+	COLUMN_X,
+	COLUMN_Y,
+	COLUMN_ROTATION,
+	COLUMN_LINEAR_VELOCITY_X,
+	COLUMN_LINEAR_VELOCITY_Y,
+	COLUMN_ANGULAR_VELOCITY,
+};
+
+// Statements are prepared before the first world step, so the planner can't know how many bodies moved
+static const int ESTIMATED_MOVE_COUNT = 1000;
+
+struct physics_moves_cursor : public sqlite3_vtab_cursor {
+	size_t index;
+	// Velocities of the current row, fetched from Box2D once when first read
+	bool has_velocity;
+	b2Vec2 linear_velocity;
+	float angular_velocity;
+};
+
+static void fetch_velocity(physics_moves_cursor *cursor, b2BodyId body_id) {
+	if (!cursor->has_velocity) {
+		cursor->linear_velocity = b2Body_GetLinearVelocity(body_id);
+		cursor->angular_velocity = b2Body_GetAngularVelocity(body_id);
+		cursor->has_velocity = true;
+	}
+}
+
+static int physics_moves_connect(sqlite3 *db, void *aux, int argc, const char *const *argv, sqlite3_vtab **out_vtab, char **out_error) {
+	int res = sqlite3_declare_vtab(db, "CREATE TABLE x(entity_id, x, y, rotation, linear_velocity_x, linear_velocity_y, angular_velocity)");
+	if (res != SQLITE_OK) {
+		return res;
+	}
+	sqlite3_vtab *vtab = (sqlite3_vtab *) sqlite3_malloc(sizeof(sqlite3_vtab));
+	if (!vtab) {
+		return SQLITE_NOMEM;
+	}
+	memset(vtab, 0, sizeof(sqlite3_vtab));
+	*out_vtab = vtab;
+	return SQLITE_OK;
+}
+
+static int physics_moves_disconnect(sqlite3_vtab *vtab) {
+	sqlite3_free(vtab);
+	return SQLITE_OK;
+}
+
+static int physics_moves_best_index(sqlite3_vtab *vtab, sqlite3_index_info *index_info) {
+	index_info->estimatedCost = ESTIMATED_MOVE_COUNT;
+	index_info->estimatedRows = ESTIMATED_MOVE_COUNT;
+	return SQLITE_OK;
+}
+
+static int physics_moves_open(sqlite3_vtab *vtab, sqlite3_vtab_cursor **out_cursor) {
+	physics_moves_cursor *cursor = (physics_moves_cursor *) sqlite3_malloc(sizeof(physics_moves_cursor));
+	if (!cursor) {
+		return SQLITE_NOMEM;
+	}
+	memset(cursor, 0, sizeof(physics_moves_cursor));
+	*out_cursor = cursor;
+	return SQLITE_OK;
+}
+
+static int physics_moves_close(sqlite3_vtab_cursor *cursor) {
+	sqlite3_free(cursor);
+	return SQLITE_OK;
+}
+
+static int physics_moves_filter(sqlite3_vtab_cursor *cursor, int index_num, const char *index_str, int argc, sqlite3_value **argv) {
+	((physics_moves_cursor *) cursor)->index = 0;
+	((physics_moves_cursor *) cursor)->has_velocity = false;
+	return SQLITE_OK;
+}
+
+static int physics_moves_next(sqlite3_vtab_cursor *cursor) {
+	((physics_moves_cursor *) cursor)->index++;
+	((physics_moves_cursor *) cursor)->has_velocity = false;
+	return SQLITE_OK;
+}
+
+static int physics_moves_eof(sqlite3_vtab_cursor *cursor) {
+	return ((physics_moves_cursor *) cursor)->index >= current_move_events.size();
+}
+
+static int physics_moves_column(sqlite3_vtab_cursor *base_cursor, sqlite3_context *ctx, int column) {
+	physics_moves_cursor *cursor = (physics_moves_cursor *) base_cursor;
+	const b2BodyMoveEvent& move_event = current_move_events[cursor->index];
+	switch (column) {
+		case COLUMN_ENTITY_ID:
+			sqlite3_result_int64(ctx, get_entity_id(move_event.bodyId));
+			break;
+
+		case COLUMN_X:
+			sqlite3_result_double(ctx, move_event.transform.p.x);
+			break;
+
+		case COLUMN_Y:
+			sqlite3_result_double(ctx, move_event.transform.p.y);
+			break;
+
+		case COLUMN_ROTATION:
+			sqlite3_result_double(ctx, b2Rot_GetAngle(move_event.transform.q) * RAD2DEG);
+			break;
+
+		case COLUMN_LINEAR_VELOCITY_X:
+			fetch_velocity(cursor, move_event.bodyId);
+			sqlite3_result_double(ctx, cursor->linear_velocity.x);
+			break;
+
+		case COLUMN_LINEAR_VELOCITY_Y:
+			fetch_velocity(cursor, move_event.bodyId);
+			sqlite3_result_double(ctx, cursor->linear_velocity.y);
+			break;
+
+		case COLUMN_ANGULAR_VELOCITY:
+			fetch_velocity(cursor, move_event.bodyId);
+			sqlite3_result_double(ctx, cursor->angular_velocity * RAD2DEG);
+			break;
+	}
+	return SQLITE_OK;
+}
+
+static int physics_moves_rowid(sqlite3_vtab_cursor *cursor, sqlite3_int64 *out_rowid) {
+	*out_rowid = ((physics_moves_cursor *) cursor)->index;
+	return SQLITE_OK;
+}
+
+static sqlite3_module physics_moves_module = {
+	0,                         // iVersion
+	nullptr,                   // xCreate: eponymous-only
+	physics_moves_connect,     // xConnect
+	physics_moves_best_index,  // xBestIndex
+	physics_moves_disconnect,  // xDisconnect
+	nullptr,                   // xDestroy
+	physics_moves_open,        // xOpen
+	physics_moves_close,       // xClose
+	physics_moves_filter,      // xFilter
+	physics_moves_next,        // xNext
+	physics_moves_eof,         // xEof
+	physics_moves_column,      // xColumn
+	physics_moves_rowid,       // xRowid
+};
+
+void register_physics_move_events(sqlite3 *db) {
+	sqlite3_create_module(db, "physics_moves", &physics_moves_module, nullptr);
+}
+
+void set_physics_move_events(std::span<const b2BodyMoveEvent> move_events) {
+	current_move_events = move_events;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <span>
+
+#include <box2d/box2d.h>
+
+typedef struct sqlite3 sqlite3;
+
+// Eponymous virtual table "physics_moves", exposing the body move events from the last world step without copying them.
+// Columns: entity_id, x, y, rotation, linear_velocity_x, linear_velocity_y, angular_velocity.
+// Velocities are only fetched from Box2D when their columns are read, once per row.
+void register_physics_move_events(sqlite3 *db);
+
+// The span must stay valid while statements read from "physics_moves", that is, until the next world step.
+void set_physics_move_events(std::span<const b2BodyMoveEvent> move_events);
@@ -76,19 +76,13 @@ ecsql::Component BoxComponent {
 	}
 };
 
-ecsql::HookSystem ShapeHookSystem {
+ecsql::BatchedHookSystem ShapeHookSystem {
 	ShapeComponent,
-	[](ecsql::HookType hook, ecsql::SQLBaseRow& old_row, ecsql::SQLBaseRow& new_row) {
-		switch (hook) {
-			case ecsql::HookType::OnInsert:
-				pending_create_shape.push_back(new_row.get<ecsql::EntityID, ecsql::EntityID>(0));
-				break;
-
-			case ecsql::HookType::OnUpdate:
-				break;
-
-			case ecsql::HookType::OnDelete:
-				break;
+	[](std::span<const ecsql::HookChange> changes) {
+		for (const ecsql::HookChange& change : changes) {
+			if (change.hook == ecsql::HookType::OnInsert) {
+				pending_create_shape.push_back(change.new_row.get<ecsql::EntityID, ecsql::EntityID>(0));
+			}
 		}
 	}
 };
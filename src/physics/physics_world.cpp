@@ -3,6 +3,7 @@
 #include <raylib.h>
 
 #include "physics_body.hpp"
+#include "physics_move_events.hpp"
 #include "physics_shape.hpp"
 #include "physics_world.hpp"
 #include "../ecsql/system.hpp"
@@ -27,6 +28,9 @@ ecsql::Component WorldComponent {
 		"enable_continuous",
 		// Simulation options
 		"substep_count NOT NULL DEFAULT 4",
+		// Set to false to skip copying body state into Position, Rotation, LinearVelocity and AngularVelocity.
+		// Read it from PhysicsBodyState instead.
+		"copy_body_state NOT NULL DEFAULT TRUE",
 	}
 };
 
@@ -111,33 +115,36 @@ ecsql::HookSystem WorldHookSystem {
 };
 
 void register_physics_world(ecsql::World& world) {
+	register_physics_move_events(world.get_db().get());
 	world.register_system({
 		"physics.UpdateWorld",
 		{
 			R"(
 				SELECT
 					entity_id,
-					fixed_delta, substep_count
+					fixed_delta, substep_count,
+					copy_body_state
 				FROM World
 					JOIN time
 			)"_dedent,
+			// `WHERE true` disambiguates the upsert's ON CONFLICT from a join constraint
 			R"(
 				INSERT INTO Position(entity_id, x, y)
-				VALUES(?1, ?2, ?3)
-				ON CONFLICT DO UPDATE SET x = ?2, y = ?3
+				SELECT entity_id, x, y FROM physics_moves WHERE true
+				ON CONFLICT DO UPDATE SET x = excluded.x, y = excluded.y
 			)"_dedent,
 			R"(
 				INSERT INTO Rotation(entity_id, z)
-				VALUES(?1, ?2)
-				ON CONFLICT DO UPDATE SET z = ?2
+				SELECT entity_id, rotation FROM physics_moves WHERE true
+				ON CONFLICT DO UPDATE SET z = excluded.z
 			)"_dedent,
 			R"(
 				REPLACE INTO LinearVelocity(entity_id, x, y)
-				VALUES(?, ?, ?)
+				SELECT entity_id, linear_velocity_x, linear_velocity_y FROM physics_moves
 			)"_dedent,
 			R"(
 				REPLACE INTO AngularVelocity(entity_id, z)
-				VALUES(?, ?)
+				SELECT entity_id, angular_velocity FROM physics_moves
 			)"_dedent,
 			R"(
 				INSERT INTO Contact(
@@ -163,10 +170,12 @@ void register_physics_world(ecsql::World& world) {
 			for (auto row : get_worlds()) {
 				auto [
 					world_entity_id,
-					timestep, substep_count
+					timestep, substep_count,
+					copy_body_state
 				] = row.get<
 					ecsql::EntityID,
-					float, int
+					float, int,
+					bool
 				>();
 
 				auto it = world_map.find(world_entity_id);
@@ -179,16 +188,15 @@ void register_physics_world(ecsql::World& world) {
 				b2WorldId world_id = it->second;
 				b2World_Step(world_id, timestep, substep_count);
 
-				// Update body positions
+				// Update body positions, one statement per component for all moved bodies
 				b2BodyEvents body_events = b2World_GetBodyEvents(world_id);
-				for (auto move_event : std::span<b2BodyMoveEvent>(body_events.moveEvents, body_events.moveCount)) {
-					ecsql::EntityID entity_id = get_entity_id(move_event.bodyId);
-
-					update_position(entity_id, move_event.transform.p);
-					update_rotation(entity_id, b2Rot_GetAngle(move_event.transform.q) * RAD2DEG);
-
-					update_linear_velocity(entity_id, b2Body_GetLinearVelocity(move_event.bodyId));
-					update_angular_velocity(entity_id, b2Body_GetAngularVelocity(move_event.bodyId) * RAD2DEG);
+				if (copy_body_state && body_events.moveCount > 0) {
+					set_physics_move_events(std::span<const b2BodyMoveEvent>(body_events.moveEvents, body_events.moveCount));
+					update_position();
+					update_rotation();
+					update_linear_velocity();
+					update_angular_velocity();
+					set_physics_move_events({});
 				}
 
 				// Update contacts
@@ -3,13 +3,35 @@
 #include "../assetio.hpp"
 #include "../xml_utils.hpp"
 
+#include <charconv>
+#include <cstring>
+#include <optional>
+
 #include <physfs_streambuf.hpp>
 
+// Image size from the IHDR chunk, which PNG requires to come first
+static std::optional<SpriteDb::Size> read_png_size(const std::filesystem::path& file) {
+	std::unique_ptr<PHYSFS_File, assetio::PHYSFS_FileDeleter> handle(PHYSFS_openRead(file.c_str()));
+	uint8_t header[24];
+	if (!handle || PHYSFS_readBytes(handle.get(), header, sizeof(header)) != sizeof(header) || memcmp(header + 12, "IHDR", 4) != 0) {
+		return std::nullopt;
+	}
+	auto read_u32_be = [](const uint8_t *bytes) {
+		return (int) ((bytes[0] << 24) | (bytes[1] << 16) | (bytes[2] << 8) | bytes[3]);
+	};
+	return SpriteDb::Size { read_u32_be(header + 16), read_u32_be(header + 20) };
+}
+
 void SpriteDb::index_path(const std::filesystem::path& texture_root_path, bool recursive) {
 	assetio::foreach_file(texture_root_path, [this](const std::filesystem::path& file) {
 		std::filesystem::path extension = file.extension();
 		if (extension == ".png" || extension == ".basis" || extension == ".ktx2") {
-			index_sprite(file.filename(), file);
+			std::string sprite_name = index_sprite(file.filename(), file);
+			if (extension == ".png") {
+				if (auto size = read_png_size(file)) {
+					sprite_sizes[sprite_name] = *size;
+				}
+			}
 		}
 		else if (extension == ".xml") {
 			std::filesystem::path image_path = sprite_to_atlas_map[file.stem()];
@@ -17,10 +39,19 @@ void SpriteDb::index_path(const std::filesystem::path& texture_root_path, bool r
 			physfs_streambuf stream(file.c_str(), std::ios::in);
 			std::istream is(&stream);
 			std::string word;
+			Size *last_size = nullptr;
 			while (is >> word) {
 				if (word.starts_with("name=")) {
 					std::filesystem::path sprite_name(extract_xml_value(word));
-					index_sprite(sprite_name, image_path);
+					last_size = &sprite_sizes[index_sprite(sprite_name, image_path)];
+				}
+				else if (last_size && word.starts_with("width=")) {
+					std::string_view width = extract_xml_value(word);
+					std::from_chars(width.begin(), width.end(), last_size->width);
+				}
+				else if (last_size && word.starts_with("height=")) {
+					std::string_view height = extract_xml_value(word);
+					std::from_chars(height.begin(), height.end(), last_size->height);
 				}
 			}
 		}
@@ -29,6 +60,7 @@ void SpriteDb::index_path(const std::filesystem::path& texture_root_path, bool r
 
 void SpriteDb::clear() {
 	sprite_to_atlas_map.clear();
+	sprite_sizes.clear();
 }
 
 std::string SpriteDb::get_atlas(const std::string& texture_name) const {
@@ -46,16 +78,28 @@ std::string SpriteDb::get_atlas(const std::string& texture_name) const {
 	}
 }
 
+SpriteDb::Size SpriteDb::get_size(const std::string& texture_name) const {
+	auto it = sprite_sizes.find(texture_name);
+	if (it != sprite_sizes.end()) {
+		return it->second;
+	}
+	else {
+		return Size { 0, 0 };
+	}
+}
+
 SpriteDb& SpriteDb::get_instance() {
 	static SpriteDb instance;
 	return instance;
 }
 
-void SpriteDb::index_sprite(const std::string& sprite_name, const std::string& atlas_path) {
+std::string SpriteDb::index_sprite(const std::string& sprite_name, const std::string& atlas_path) {
 #if defined(DEBUG) && !defined(NDEBUG)
 	if (sprite_to_atlas_map.contains(sprite_name)) {
 		std::cerr << "FIXME: duplicated sprite " << sprite_name << ". Previously defined in " << sprite_to_atlas_map[sprite_name] << " and redefined in " << atlas_path << std::endl;
 	}
 #endif
-	sprite_to_atlas_map[std::filesystem::path(sprite_name).replace_extension()] = atlas_path;
+	std::string name = std::filesystem::path(sprite_name).replace_extension();
+	sprite_to_atlas_map[name] = atlas_path;
+	return name;
 }
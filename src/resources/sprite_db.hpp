@@ -7,15 +7,24 @@
 
 class SpriteDb {
 public:
+	struct Size {
+		int width;
+		int height;
+	};
+
 	void index_path(const std::filesystem::path& texture_root_path, bool recursive = true);
 	void clear();
 
 	std::string get_atlas(const std::string& texture_name) const;
+	// Source rect size, known without loading textures.
+	// Only PNG images and atlas subtextures have sizes, other sprites are 0x0.
+	Size get_size(const std::string& texture_name) const;
 
 	static SpriteDb& get_instance();
 
 private:
 	std::unordered_map<std::string, std::string> sprite_to_atlas_map;
+	std::unordered_map<std::string, Size> sprite_sizes;
 
-	void index_sprite(const std::string& sprite_name, const std::string& atlas_path);
+	std::string index_sprite(const std::string& sprite_name, const std::string& atlas_path);
 };
@@ -1,4 +1,5 @@
-local assert, pairs, select, type = assert, pairs, select, type
+local assert, error, ipairs, math_huge, math_type, pairs, select, tostring, type = assert, error, ipairs, math.huge, math.type, pairs, select, tostring, type
+local string_format, string_gsub = string.format, string.gsub
 local table_insert, table_concat, table_unpack = table.insert, table.concat, table.unpack
 
 --- @param name string
@@ -28,14 +29,16 @@ function component(name, t)
 end
 
 --- @param component_name string
---- @param f function(hook: string, old_row, new_row)
-function hook_system(component_name, f)
-    world:register_hook_system(component_name, f)
+--- @param f function(hook: string, old_row, new_row)|function(changes: table)
+--- @param batched boolean|nil If true, `f` receives arrays of `{ hook, old_row, new_row }` once per batch instead of once per row
+function hook_system(component_name, f, batched)
+    world:register_hook_system(component_name, f, batched)
 end
 
-local function create_component_internal(component_name, entity_id, fields)
+local function create_component_internal(schema, component_name, entity_id, fields)
     local sql = {
         "INSERT INTO ",
+        schema,
         component_name,
         "(entity_id",
     }
@@ -55,8 +58,13 @@ local function create_component_internal(component_name, entity_id, fields)
     world:execute_sql(table_concat(sql), entity_id, table_unpack(values))
 end
 
-local function create_entity_internal(name, t)
-    local entity_id = world:create_entity(name, t.parent_id)
+local function create_entity_internal(name, t, schema)
+    local entity_id
+    if schema then
+        entity_id = world:create_prefab_entity(name, t.parent_id)
+    else
+        entity_id = world:create_entity(name, t.parent_id)
+    end
     for component_name, fields in pairs(t) do
         if component_name == "parent_id" then
             goto continue
@@ -64,10 +72,10 @@ local function create_entity_internal(name, t)
 
         if #fields > 0 then
             for i = 1, #fields do
-                create_component_internal(component_name, entity_id, fields[i])
+                create_component_internal(schema or "", component_name, entity_id, fields[i])
             end
         else
-            create_component_internal(component_name, entity_id, fields)
+            create_component_internal(schema or "", component_name, entity_id, fields)
         end
         ::continue::
     end
@@ -89,6 +97,84 @@ function entity(name, t)
     end
 end
 
+local function create_prefab_internal(name, t)
+    if not t.parent_id then
+        -- redefining a prefab replaces it
+        world:delete_prefab(name)
+    end
+    return create_entity_internal(name, t, "prefab.")
+end
+
+--- Define a prefab, or one of its children when `parent_id` is set.
+--- Entity IDs returned are only valid as `parent_id` of other prefab entities.
+--- @param name string
+--- @param t table|nil
+--- @return integer|function
+function prefab(name, t)
+    if t then
+        return create_prefab_internal(name, t)
+    else
+        return function(t)
+            return create_prefab_internal(name, t)
+        end
+    end
+end
+
+local json_escapes = {
+    ['"'] = '\\"',
+    ['\\'] = '\\\\',
+    ['\n'] = '\\n',
+    ['\r'] = '\\r',
+    ['\t'] = '\\t',
+}
+
+local function to_json(value)
+    local value_type = type(value)
+    if value_type == "table" then
+        local items = {}
+        if #value > 0 then
+            for i, item in ipairs(value) do
+                items[i] = to_json(item)
+            end
+            return "[" .. table_concat(items, ",") .. "]"
+        else
+            for key, item in pairs(value) do
+                items[#items + 1] = to_json(tostring(key)) .. ":" .. to_json(item)
+            end
+            return "{" .. table_concat(items, ",") .. "}"
+        end
+    elseif value_type == "string" then
+        return '"' .. string_gsub(value, '[%c"\\]', function(c)
+            return json_escapes[c] or string_format("\\u%04x", c:byte())
+        end) .. '"'
+    elseif value_type == "number" then
+        if math_type(value) == "integer" then
+            return tostring(value)
+        elseif value ~= value or value == math_huge or value == -math_huge then
+            error("NaN and infinity cannot be encoded in JSON", 2)
+        else
+            return string_format("%.17g", value)
+        end
+    elseif value_type == "boolean" then
+        return tostring(value)
+    else
+        return "null"
+    end
+end
+
+--- Clone a prefab `count` times.
+--- `overrides` replaces component fields of the created roots, either the same table for all instances
+--- or an array with one table per instance, e.g. `{ Position = { x = 10, y = 20 } }`.
+--- @param name string
+--- @param count integer|nil
+--- @param overrides table|nil
+--- @param parent_id integer|nil
+--- @return integer first_id First root, followed by its descendants and then the next instances
+--- @return integer entities_per_instance
+function instantiate(name, count, overrides, parent_id)
+    return world:instantiate(name, count or 1, overrides and to_json(overrides), parent_id)
+end
+
 --- @param script string
 --- @return ExecutedSQL|nil
 function sql(script, ...)
@@ -8,6 +8,7 @@
 #include "lua_scripting.hpp"
 #include "../assetio.hpp"
 #include "../memory.hpp"
+#include "../snapshot.hpp"
 #include "../ecsql/background_system.hpp"
 #include "../ecsql/prepared_sql.hpp"
 #include "../ecsql/system.hpp"
@@ -32,7 +33,8 @@ static void lua_register_system(sol::this_state L, ecsql::World& world, std::str
 	std::string prefixed_name = "lua.";
 	prefixed_name += name;
 	if (lua_function) {
-		world.register_system({
+		// The Lua state is not thread-safe
+		world.register_system(ecsql::System {
 			prefixed_name,
 			sqls,
 			[lua_function](ecsql::World& world, std::vector<ecsql::PreparedSQL>& prepared_sql) {
@@ -41,7 +43,7 @@ static void lua_register_system(sol::this_state L, ecsql::World& world, std::str
 					throw result.get<sol::error>();
 				}
 			}
-		}, use_fixed_delta);
+		}.with_phase(ecsql::SystemPhase::MainThread), use_fixed_delta);
 	}
 	else {
 		world.register_system({ prefixed_name, sqls }, use_fixed_delta);
@@ -70,7 +72,38 @@ static void lua_register_component(sol::this_state L, ecsql::World& world, std::
 	});
 }
 
-static void lua_register_hook_system(sol::this_state L, ecsql::World& world, std::string_view component_name, sol::protected_function lua_function) {
+static const char *hook_type_name(ecsql::HookType hook) {
+	switch (hook) {
+		case ecsql::HookType::OnInsert: return "insert";
+		case ecsql::HookType::OnUpdate: return "update";
+		case ecsql::HookType::OnDelete: return "delete";
+	}
+	return nullptr;
+}
+
+static void lua_register_hook_system(sol::this_state L, ecsql::World& world, std::string_view component_name, sol::protected_function lua_function, sol::optional<bool> batched) {
+	// Lua hooks are main thread only, for the Lua state is not thread-safe
+	if (batched.value_or(false)) {
+		// Batched hooks get a single array of { hook, old_row, new_row } per delivery
+		world.register_hook_system(ecsql::BatchedHookSystem {
+			component_name,
+			[lua_function](std::span<const ecsql::HookChange> changes) {
+				sol::state_view state = lua_function.lua_state();
+				sol::table lua_changes = state.create_table(changes.size(), 0);
+				for (int i = 0; i < changes.size(); i++) {
+					const ecsql::HookChange& change = changes[i];
+					lua_changes[i + 1] = state.create_table_with(
+						1, hook_type_name(change.hook),
+						2, change.hook != ecsql::HookType::OnInsert ? sol::make_object(state, (const ecsql::SQLBaseRow *) &change.old_row) : sol::make_object(state, sol::lua_nil),
+						3, change.hook != ecsql::HookType::OnDelete ? sol::make_object(state, (const ecsql::SQLBaseRow *) &change.new_row) : sol::make_object(state, sol::lua_nil)
+					);
+				}
+				lua_function(lua_changes);
+			},
+			true,
+		});
+		return;
+	}
 	world.register_hook_system({
 		component_name,
 		[lua_function](ecsql::HookType hook, ecsql::SQLBaseRow& old_row, ecsql::SQLBaseRow& new_row) {
@@ -88,6 +121,7 @@ static void lua_register_hook_system(sol::this_state L, ecsql::World& world, std
 					break;
 			}
 		},
+		true,
 	});
 }
 
@@ -180,16 +214,31 @@ static void register_usertypes(sol::state_view& state) {
 			sol::resolve<int(std::string_view)>(&ecsql::World::delete_entity)
 		),
 		"find_entity", &ecsql::World::find_entity,
+		"create_prefab_entity", &ecsql::World::create_prefab_entity,
+		"delete_prefab", &ecsql::World::delete_prefab,
+		"instantiate", [](ecsql::World& world, std::string_view prefab, sol::optional<int> count, std::optional<std::string_view> overrides_json, std::optional<ecsql::EntityID> parent) {
+			ecsql::PrefabInstances instances = world.instantiate(prefab, count.value_or(1), overrides_json, parent);
+			return std::make_pair(instances.first_id, instances.entities_per_instance);
+		},
 		"prepare_sql", [](ecsql::World& world, std::string_view sql, sol::optional<bool> is_persistent) {
 			return world.prepare_sql(sql, is_persistent.value_or(false));
 		},
 		"execute_sql", [](sol::this_state L, ecsql::World& world, std::string_view sql, sol::variadic_args args) {
-			ecsql::PreparedSQL prepared_sql = world.prepare_sql(sql);
+			ecsql::PreparedSQL prepared_sql = world.cached_sql(sql);
 			return lua_prepared_sql_call(L, prepared_sql, args);
 		},
 		"execute_sql_script", &ecsql::World::execute_sql_script,
+		"track_changes", &ecsql::World::track_changes,
+		"get_frame", &ecsql::World::get_frame,
 		"backup_into", [](ecsql::World& world, const char *filename, std::optional<const char *>db_name) {
-			world.backup_into(filename, db_name.value_or("main"));
+			// Written in the background, so that autosaving does not stall the frame
+			world.backup_into_async(filename, db_name.value_or("main"));
+		},
+		"save_snapshot", [](ecsql::World& world, const char *filename, std::optional<const char *>db_name) {
+			snapshot::save_async(world, filename, db_name.value_or("main"));
+		},
+		"load_snapshot", [](ecsql::World& world, const char *filename, std::optional<const char *>db_name) {
+			return snapshot::load(world, filename, db_name.value_or("main"));
 		}
 	);
 
@@ -0,0 +1,93 @@
+#include <cstdlib>
+#include <cstring>
+
+#include "size_class_pool.hpp"
+
+SizeClassPool::~SizeClassPool() {
+	for (void *chunk : chunks) {
+		free(chunk);
+	}
+}
+
+void *SizeClassPool::allocate(size_t size) {
+	int class_index = size_class(size);
+	if (class_index < 0) {
+		stats.fallback_allocations++;
+		return malloc(size);
+	}
+
+	stats.pool_allocations++;
+	if (FreeBlock *block = free_lists[class_index]) {
+		free_lists[class_index] = block->next;
+		return block;
+	}
+	return allocate_from_chunk(CLASS_SIZES[class_index]);
+}
+
+void SizeClassPool::deallocate(void *ptr, size_t size) {
+	if (!ptr) {
+		return;
+	}
+	int class_index = size_class(size);
+	if (class_index < 0) {
+		free(ptr);
+		return;
+	}
+	FreeBlock *block = (FreeBlock *) ptr;
+	block->next = free_lists[class_index];
+	free_lists[class_index] = block;
+}
+
+void *SizeClassPool::reallocate(void *ptr, size_t old_size, size_t new_size) {
+	if (!ptr) {
+		return allocate(new_size);
+	}
+	int old_class = size_class(old_size);
+	int new_class = size_class(new_size);
+	if (old_class >= 0 && old_class == new_class) {
+		return ptr;
+	}
+	if (old_class < 0 && new_class < 0) {
+		stats.fallback_allocations++;
+		return realloc(ptr, new_size);
+	}
+	void *new_ptr = allocate(new_size);
+	if (new_ptr) {
+		memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+		deallocate(ptr, old_size);
+	}
+	return new_ptr;
+}
+
+const SizeClassPool::Stats& SizeClassPool::get_stats() const {
+	return stats;
+}
+
+int SizeClassPool::size_class(size_t size) {
+	if (size == 0 || size > MAX_BLOCK_SIZE) {
+		return -1;
+	}
+	for (int i = 0; i < CLASS_SIZES.size(); i++) {
+		if (size <= CLASS_SIZES[i]) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+void *SizeClassPool::allocate_from_chunk(size_t class_size) {
+	if ((size_t) (chunk_end - chunk_cursor) < class_size) {
+		// The rest of the current chunk is lost, which is at most MAX_BLOCK_SIZE bytes
+		char *chunk = (char *) malloc(CHUNK_SIZE);
+		if (!chunk) {
+			return nullptr;
+		}
+		chunks.push_back(chunk);
+		chunk_cursor = chunk;
+		chunk_end = chunk + CHUNK_SIZE;
+		stats.chunk_bytes += CHUNK_SIZE;
+	}
+	void *block = chunk_cursor;
+	chunk_cursor += class_size;
+	return block;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Free-list allocator for small blocks, grouped in a few size classes and carved from big chunks.
+// Chunks are only returned to the system when the pool is destroyed.
+// Callers pass block sizes back when freeing, like Lua allocators receive them, so blocks have no headers.
+// Not thread-safe.
+class SizeClassPool {
+public:
+	static constexpr size_t MAX_BLOCK_SIZE = 256;
+
+	struct Stats {
+		uint64_t pool_allocations = 0;
+		uint64_t fallback_allocations = 0;
+		size_t chunk_bytes = 0;
+	};
+
+	SizeClassPool() = default;
+	SizeClassPool(const SizeClassPool&) = delete;
+	~SizeClassPool();
+
+	void *allocate(size_t size);
+	void deallocate(void *ptr, size_t size);
+	void *reallocate(void *ptr, size_t old_size, size_t new_size);
+
+	const Stats& get_stats() const;
+
+private:
+	static constexpr size_t CHUNK_SIZE = 64 * 1024;
+	static constexpr std::array<size_t, 8> CLASS_SIZES = { 16, 32, 48, 64, 96, 128, 192, 256 };
+
+	struct FreeBlock {
+		FreeBlock *next;
+	};
+
+	std::array<FreeBlock *, CLASS_SIZES.size()> free_lists {};
+	std::vector<void *> chunks;
+	char *chunk_cursor = nullptr;
+	char *chunk_end = nullptr;
+	Stats stats;
+
+	static int size_class(size_t size);
+	void *allocate_from_chunk(size_t class_size);
+};
@@ -0,0 +1,105 @@
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include <raylib.h>
+#include <tracy/Tracy.hpp>
+
+#include "snapshot.hpp"
+#include "ecsql/world.hpp"
+
+namespace snapshot {
+
+static const char MAGIC[8] = "ECSQLZ1";
+static const size_t HEADER_SIZE = sizeof(MAGIC) + sizeof(uint64_t);
+
+struct MemFreeDeleter {
+	void operator()(unsigned char *ptr) {
+		MemFree(ptr);
+	}
+};
+
+std::vector<uint8_t> compress(const ecsql::SerializedDatabase& serialized) {
+	ZoneScoped;
+	int compressed_size = 0;
+	std::unique_ptr<unsigned char, MemFreeDeleter> compressed(CompressData(serialized.data.get(), serialized.size, &compressed_size));
+	if (!compressed) {
+		return {};
+	}
+
+	std::vector<uint8_t> snapshot(HEADER_SIZE + compressed_size);
+	memcpy(snapshot.data(), MAGIC, sizeof(MAGIC));
+	uint64_t size = serialized.size;
+	for (int i = 0; i < sizeof(uint64_t); i++) {
+		snapshot[sizeof(MAGIC) + i] = (size >> (i * 8)) & 0xff;
+	}
+	memcpy(snapshot.data() + HEADER_SIZE, compressed.get(), compressed_size);
+	return snapshot;
+}
+
+ecsql::SerializedDatabase decompress(std::span<const uint8_t> snapshot) {
+	ZoneScoped;
+	if (snapshot.size() < HEADER_SIZE || memcmp(snapshot.data(), MAGIC, sizeof(MAGIC)) != 0) {
+		std::cerr << "Error decompressing snapshot: invalid header" << std::endl;
+		return {};
+	}
+	uint64_t size = 0;
+	for (int i = 0; i < sizeof(uint64_t); i++) {
+		size |= (uint64_t) snapshot[sizeof(MAGIC) + i] << (i * 8);
+	}
+
+	int decompressed_size = 0;
+	std::unique_ptr<unsigned char, MemFreeDeleter> decompressed(DecompressData(snapshot.data() + HEADER_SIZE, snapshot.size() - HEADER_SIZE, &decompressed_size));
+	if (!decompressed || decompressed_size != size) {
+		std::cerr << "Error decompressing snapshot: expected " << size << " bytes, got " << decompressed_size << std::endl;
+		return {};
+	}
+
+	// `sqlite3_deserialize` needs memory from `sqlite3_malloc` to take ownership of it
+	ecsql::SerializedDatabase serialized;
+	serialized.data.reset((unsigned char *) sqlite3_malloc64(size));
+	if (!serialized.data) {
+		return {};
+	}
+	memcpy(serialized.data.get(), decompressed.get(), size);
+	serialized.size = size;
+	return serialized;
+}
+
+std::future<bool> save_async(ecsql::World& world, const char *filename, const char *db_name) {
+	ZoneScoped;
+	auto promise = std::make_shared<std::promise<bool>>();
+	std::future<bool> result = promise->get_future();
+
+	auto serialized = std::make_shared<ecsql::SerializedDatabase>(world.serialize(db_name));
+	if (!*serialized) {
+		promise->set_value(false);
+		return result;
+	}
+
+	world.dispatch_background([promise, serialized, filename = std::string(filename)]() {
+		ZoneScopedN("snapshot::save_async.write");
+		std::vector<uint8_t> snapshot = compress(*serialized);
+		serialized->data.reset();
+		promise->set_value(!snapshot.empty() && SaveFileData(filename.c_str(), snapshot.data(), snapshot.size()));
+	});
+	return result;
+}
+
+bool load(ecsql::World& world, const char *filename, const char *db_name) {
+	ZoneScoped;
+	int size = 0;
+	std::unique_ptr<unsigned char, MemFreeDeleter> data(LoadFileData(filename, &size));
+	if (!data) {
+		std::cerr << "Error loading snapshot \"" << filename << "\"" << std::endl;
+		return false;
+	}
+	ecsql::SerializedDatabase serialized = decompress(std::span<const uint8_t>(data.get(), size));
+	if (!serialized) {
+		return false;
+	}
+	return world.restore_from(std::move(serialized), db_name);
+}
+
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <future>
+#include <span>
+#include <vector>
+
+#include "ecsql/sql_utility.hpp"
+
+namespace ecsql {
+	class World;
+}
+
+// Compressed database snapshots, for save slots and rewinding.
+// Format: "ECSQLZ1\0" magic, uncompressed size as a little endian 64-bit integer, followed by deflate data.
+// Files are read and written through raylib, so they live in the assetio write directory.
+namespace snapshot {
+
+std::vector<uint8_t> compress(const ecsql::SerializedDatabase& serialized);
+ecsql::SerializedDatabase decompress(std::span<const uint8_t> snapshot);
+
+// Serializes the database on the calling thread, then compresses and writes it on a world worker thread
+std::future<bool> save_async(ecsql::World& world, const char *filename, const char *db_name = "main");
+bool load(ecsql::World& world, const char *filename, const char *db_name = "main");
+
+}
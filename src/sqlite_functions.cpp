@@ -3,8 +3,20 @@
 
 #include "sqlite_functions.hpp"
 #include "ecsql/sql_function.hpp"
+#include "resources/sprite_db.hpp"
+
+// SpriteDb is only written before the world is created, so these are safe in any thread
+static sqlite3_int64 SpriteWidth(std::string_view sprite_name) {
+	return SpriteDb::get_instance().get_size(std::string(sprite_name)).width;
+}
+
+static sqlite3_int64 SpriteHeight(std::string_view sprite_name) {
+	return SpriteDb::get_instance().get_size(std::string(sprite_name)).height;
+}
 
 void register_sqlite_functions(sqlite3 *db) {
 	ecsql::register_sql_function(db, Clamp, "clamp", SQLITE_UTF8 | SQLITE_DETERMINISTIC | SQLITE_INNOCUOUS);
 	ecsql::register_sql_function(db, IsKeyReleased, "IsKeyReleased", SQLITE_UTF8 | SQLITE_INNOCUOUS);
+	ecsql::register_sql_function(db, SpriteWidth, "SpriteWidth", SQLITE_UTF8 | SQLITE_INNOCUOUS);
+	ecsql::register_sql_function(db, SpriteHeight, "SpriteHeight", SQLITE_UTF8 | SQLITE_INNOCUOUS);
 }
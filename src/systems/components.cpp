@@ -117,6 +117,14 @@ ecsql::Component ColorComponent {
 	}
 };
 
+// Sprites are drawn in increasing layer order, 0 by default
+ecsql::Component DrawLayerComponent {
+	"DrawLayer",
+	{
+		"layer NOT NULL DEFAULT 0",
+	}
+};
+
 ecsql::Component TextComponent {
 	"Text",
 	{
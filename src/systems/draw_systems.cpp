@@ -7,7 +7,9 @@
 #include <rlgl.h>
 
 #include "draw_systems.hpp"
+#include "sprite_render_queue.hpp"
 #include "../ecsql/system.hpp"
+#include "../ecsql/system_profiler.hpp"
 #include "../flyweights/line_strip_flyweight.hpp"
 #include "../flyweights/model_flyweight.hpp"
 #include "../flyweights/sprite_flyweight.hpp"
@@ -16,6 +18,62 @@
 #define DEFAULT_TEXT_COLOR BLACK
 #define DEFAULT_LINE_STRIP_COLOR BLACK
 
+#define DRAW_TEXTURE_COLUMNS \
+	std::string_view, \
+	Vector2, \
+	std::optional<Vector2>, \
+	std::optional<Vector2>, \
+	float, \
+	std::optional<float>, \
+	std::optional<Vector2>, \
+	std::optional<Vector2>, \
+	std::optional<Color>, \
+	float, \
+	int
+
+// World space rectangle visible through the first Camera2D, or the screen when there is none.
+// Rotated cameras use a square covering every rotation.
+#define CAMERA_VIEW_SQL R"(
+			WITH
+				camera AS (
+					SELECT
+						coalesce(Camera2D.offset_x, 0) AS offset_x,
+						coalesce(Camera2D.offset_y, 0) AS offset_y,
+						coalesce(Camera2D.target_x, 0) AS target_x,
+						coalesce(Camera2D.target_y, 0) AS target_y,
+						coalesce(Camera2D.rotation, 0) != 0 AS is_rotated,
+						coalesce(nullif(Camera2D.zoom, 0), 1) AS zoom,
+						screen.width, screen.height
+					FROM screen
+						LEFT JOIN Camera2D
+					LIMIT 1
+				),
+				reach AS (
+					SELECT
+						*,
+						max(offset_x, width - offset_x) + max(offset_y, height - offset_y) AS rotated_reach
+					FROM camera
+				),
+				camera_view AS (
+					SELECT
+						target_x - iif(is_rotated, rotated_reach, offset_x) / zoom AS min_x,
+						target_x + iif(is_rotated, rotated_reach, width - offset_x) / zoom AS max_x,
+						target_y - iif(is_rotated, rotated_reach, offset_y) / zoom AS min_y,
+						target_y + iif(is_rotated, rotated_reach, height - offset_y) / zoom AS max_y
+					FROM reach
+				)
+)"
+
+// Filled by sprite draw systems, drawn sorted by layer and batched by texture where it keeps the draw order, by "FlushSprites"
+static SpriteRenderQueue sprite_render_queue;
+
+// Culled rows never leave SQL, so count candidates only while profiling
+static void report_culled(ecsql::World& world, ecsql::PreparedSQL& count_candidates, int drawn) {
+	if (world.is_profiling_enabled()) {
+		ecsql::SystemProfiler::report_culled(count_candidates().get<int>() - drawn);
+	}
+}
+
 static Vector2 interpolated_position(Vector2 position, std::optional<Vector2> previous_position, float fixed_delta_progress) {
 	if (previous_position) {
 		return Vector2Lerp(*previous_position, position, fixed_delta_progress);
@@ -41,8 +99,14 @@ static float interpolated_rotation(float rotation, std::optional<float> previous
 	}
 }
 
+// Draw systems only read the world, so they may render the last committed frame while the next one is simulated
+static ecsql::System presentation_system(ecsql::System&& system) {
+	system.phase = ecsql::SystemPhase::Presentation;
+	return system;
+}
+
 void register_draw_systems(ecsql::World& world) {
-	world.register_system({
+	world.register_system(presentation_system({
 		"ClearScreen",
 		R"(
 			SELECT r, g, b, a
@@ -57,8 +121,8 @@ void register_draw_systems(ecsql::World& world) {
 				}
 			}
 		},
-	});
-	world.register_system({
+	}));
+	world.register_system(presentation_system({
 		"BeginCamera2D",
 		R"(
 			SELECT
@@ -74,38 +138,47 @@ void register_draw_systems(ecsql::World& world) {
 			});
 			BeginMode2D(camera);
 		},
-	});
-	world.register_system({
+	}));
+	world.register_system(presentation_system({
 		"DrawSpriteRect",
-		R"(
+		{
+			CAMERA_VIEW_SQL R"(
 			SELECT
 				path,
 				Rectangle.x, Rectangle.y, width, height,
 				Rotation.z,
-				r, g, b, a
-			FROM Sprite
+				r, g, b, a,
+				coalesce(DrawLayer.layer, 0)
+			FROM camera_view, entity_bounds
+				JOIN Sprite USING(entity_id)
 				JOIN Rectangle USING(entity_id)
 				LEFT JOIN Rotation USING(entity_id)
 				LEFT JOIN Color USING(entity_id)
-		)"_dedent,
-		[](auto& sql) {
-			for (ecsql::SQLRow row : sql()) {
-				auto [sprite_name, rectangle, rotation, color] = row.get<std::string_view, Rectangle, float, std::optional<Color>>();
+				LEFT JOIN DrawLayer USING(entity_id)
+			WHERE entity_bounds.max_x >= camera_view.min_x AND entity_bounds.min_x <= camera_view.max_x
+				AND entity_bounds.max_y >= camera_view.min_y AND entity_bounds.min_y <= camera_view.max_y
+			)"_dedent,
+			"SELECT count(*) FROM Sprite JOIN Rectangle USING(entity_id)",
+		},
+		[](ecsql::World& world, std::vector<ecsql::PreparedSQL>& sqls) {
+			int drawn = 0;
+			for (ecsql::SQLRow row : sqls[0]()) {
+				drawn++;
+				auto [sprite_name, rectangle, rotation, color, layer] = row.get<std::string_view, Rectangle, float, std::optional<Color>, int>();
 				auto sprite = SpriteFlyweight.get(sprite_name);
 				Rectangle source_rect = sprite->source_rect;
 				Vector2 center { rectangle.width * 0.5f, rectangle.height * 0.5f };
 				rectangle.x += center.x;
 				rectangle.y += center.y;
-				{
-					ZoneScopedN("DrawTexturePro");
-					DrawTexturePro(sprite->texture, source_rect, rectangle, center, rotation, color.value_or(WHITE));
-				}
+				sprite_render_queue.push(sprite->texture, source_rect, rectangle, center, rotation, color.value_or(WHITE), layer);
 			}
+			report_culled(world, sqls[1], drawn);
 		},
-	});
-	world.register_system({
+	}));
+	world.register_system(presentation_system({
 		"DrawTexture",
-		R"(
+		{
+			CAMERA_VIEW_SQL R"(
 			SELECT
 				path,
 				Position.x, Position.y,
@@ -116,8 +189,10 @@ void register_draw_systems(ecsql::World& world) {
 				Size.width, Size.height,
 				Scale.x, Scale.y,
 				r, g, b, a,
-				fixed_delta_progress
-			FROM Sprite
+				fixed_delta_progress,
+				coalesce(DrawLayer.layer, 0)
+			FROM camera_view, entity_bounds
+				JOIN Sprite USING(entity_id)
 				JOIN Position USING(entity_id)
 				LEFT JOIN PreviousPosition USING(entity_id)
 				LEFT JOIN Pivot USING(entity_id)
@@ -126,10 +201,16 @@ void register_draw_systems(ecsql::World& world) {
 				LEFT JOIN Size USING(entity_id)
 				LEFT JOIN Scale USING(entity_id)
 				LEFT JOIN Color USING(entity_id)
+				LEFT JOIN DrawLayer USING(entity_id)
 				JOIN time
-		)"_dedent,
-		[](auto& sql) {
-			for (ecsql::SQLRow row : sql()) {
+			WHERE entity_bounds.max_x >= camera_view.min_x AND entity_bounds.min_x <= camera_view.max_x
+				AND entity_bounds.max_y >= camera_view.min_y AND entity_bounds.min_y <= camera_view.max_y
+			)"_dedent,
+			"SELECT count(*) FROM Sprite JOIN Position USING(entity_id)",
+		},
+		[](ecsql::World& world, std::vector<ecsql::PreparedSQL>& sqls) {
+			int drawn = 0;
+			for (auto it = sqls[0]().begin(); it; ++it, drawn++) {
 				auto [
 					sprite_name,
 					position,
@@ -140,19 +221,9 @@ void register_draw_systems(ecsql::World& world) {
 					size,
 					scale,
 					color,
-					fixed_delta_progress
-				] = row.get<
-					std::string_view,
-					Vector2,
-					std::optional<Vector2>,
-					std::optional<Vector2>,
-					float,
-					std::optional<float>,
-					std::optional<Vector2>,
-					std::optional<Vector2>,
-					std::optional<Color>,
-					float
-				>();
+					fixed_delta_progress,
+					layer
+				] = it.statement_row().get<DRAW_TEXTURE_COLUMNS>();
 				position = interpolated_position(position, previous_position, fixed_delta_progress);
 				rotation = interpolated_rotation(rotation, previous_rotation, fixed_delta_progress);
 
@@ -170,37 +241,52 @@ void register_draw_systems(ecsql::World& world) {
 					size->y * scale->y,
 				};
 				Vector2 pivot { dest.width * normalized_pivot->x, dest.height * normalized_pivot->y };
-				{
-					ZoneScopedN("DrawTexturePro");
-					DrawTexturePro(sprite->texture, source_rect, dest, pivot, rotation, color.value_or(WHITE));
-				}
+				sprite_render_queue.push(sprite->texture, source_rect, dest, pivot, rotation, color.value_or(WHITE), layer);
 			}
+			report_culled(world, sqls[1], drawn);
 		},
-	});
-	world.register_system({
+	}).expect_columns<DRAW_TEXTURE_COLUMNS>());
+	// Text and line strips are drawn over sprites
+	world.register_system(presentation_system({
+		"FlushSprites",
+		[]() {
+			sprite_render_queue.flush();
+		},
+	}));
+	world.register_system(presentation_system({
 		"DrawText",
-		R"(
+		{
+			CAMERA_VIEW_SQL R"(
 			SELECT
 				text, size,
 				x, y, width, height,
 				r, g, b, a
-			FROM Text
+			FROM camera_view, entity_bounds
+				JOIN Text USING(entity_id)
 				JOIN Rectangle USING(entity_id)
 				LEFT JOIN Color USING(entity_id)
-		)"_dedent,
-		[](auto& sql) {
-			for (ecsql::SQLRow row : sql()) {
+			WHERE entity_bounds.max_x >= camera_view.min_x AND entity_bounds.min_x <= camera_view.max_x
+				AND entity_bounds.max_y >= camera_view.min_y AND entity_bounds.min_y <= camera_view.max_y
+			)"_dedent,
+			"SELECT count(*) FROM Text JOIN Rectangle USING(entity_id)",
+		},
+		[](ecsql::World& world, std::vector<ecsql::PreparedSQL>& sqls) {
+			int drawn = 0;
+			for (ecsql::SQLRow row : sqls[0]()) {
+				drawn++;
 				auto [text, size, rect, color] = row.get<const char *, int, Rectangle, std::optional<Color>>();
 				{
 					ZoneScopedN("DrawText");
 					DrawText(text, rect.x, rect.y, size, color.value_or(DEFAULT_TEXT_COLOR));
 				}
 			}
+			report_culled(world, sqls[1], drawn);
 		}
-	});
-	world.register_system({
+	}));
+	world.register_system(presentation_system({
 		"DrawLineStrip",
-		R"(
+		{
+			CAMERA_VIEW_SQL R"(
 			SELECT
 				path,
 				Position.x, Position.y,
@@ -218,9 +304,21 @@ void register_draw_systems(ecsql::World& world) {
 				LEFT JOIN Scale USING(entity_id)
 				LEFT JOIN Color USING(entity_id)
 				JOIN time
-		)"_dedent,
-		[](auto& sql) {
-			for (ecsql::SQLRow row : sql()) {
+			-- Points are not known in SQL, so only strips with an explicit Size get culled
+			WHERE entity_id NOT IN (SELECT entity_id FROM Size)
+				OR entity_id IN (
+					SELECT entity_id
+					FROM camera_view, entity_bounds
+					WHERE entity_bounds.max_x >= camera_view.min_x AND entity_bounds.min_x <= camera_view.max_x
+						AND entity_bounds.max_y >= camera_view.min_y AND entity_bounds.min_y <= camera_view.max_y
+				)
+			)"_dedent,
+			"SELECT count(*) FROM PointStrip JOIN Position USING(entity_id)",
+		},
+		[](ecsql::World& world, std::vector<ecsql::PreparedSQL>& sqls) {
+			int drawn = 0;
+			for (ecsql::SQLRow row : sqls[0]()) {
+				drawn++;
 				auto [
 					points_path,
 					position,
@@ -254,15 +352,16 @@ void register_draw_systems(ecsql::World& world) {
 					DrawLineStrip(points.data(), points.size(), color.value_or(DEFAULT_LINE_STRIP_COLOR));
 				rlPopMatrix();
 			}
+			report_culled(world, sqls[1], drawn);
 		},
-	});
-	world.register_system({
+	}));
+	world.register_system(presentation_system({
 		"EndCamera2D",
 		[]() {
 			EndMode2D();
 		},
-	});
-	world.register_system({
+	}));
+	world.register_system(presentation_system({
 		"DrawModel",
 		{
 			R"(
@@ -318,8 +417,9 @@ void register_draw_systems(ecsql::World& world) {
 				}
 			}
 		},
-	});
-	world.register_system({
+	}));
+	// raylib's camera controls read input, which is only safe in the main thread
+	world.register_system(ecsql::System {
 		"UpdateCamera",
 		{
 			R"(
@@ -387,5 +487,5 @@ void register_draw_systems(ecsql::World& world) {
 				}
 			}
 		},
-	});
+	}.with_phase(ecsql::SystemPhase::MainThread));
 }
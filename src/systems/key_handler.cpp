@@ -17,7 +17,8 @@ void register_key_handler(ecsql::World& world) {
 		}
 	}
 
-	world.register_system({
+	// raylib input functions are only safe in the main thread
+	world.register_system(ecsql::System {
 		"KeyboardHandler",
 		{
 			"UPDATE keyboard SET state = 'pressed' WHERE key = ?",
@@ -57,7 +58,7 @@ void register_key_handler(ecsql::World& world) {
 				}
 			}
 		}
-	});
+	}.with_phase(ecsql::SystemPhase::MainThread));
 
 	// TODO: handle mouse and gamepad inputs before updating input_action
 
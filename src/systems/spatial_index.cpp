@@ -0,0 +1,275 @@
+#include <cstring>
+#include <optional>
+
+#include <cdedent.hpp>
+#include <sqlite3.h>
+
+#include "spatial_index.hpp"
+#include "../ecsql/system.hpp"
+
+// Tables whose changes move entity bounds
+static const char *bounds_components[] = {
+	"Position",
+	"Size",
+	"Scale",
+	"Pivot",
+	"Rotation",
+	"Rectangle",
+	"Sprite",
+};
+
+// entities_in_rect(x0, y0, x1, y1) table-valued function
+enum EntitiesInRectColumn {
+	COLUMN_ENTITY_ID,
+	COLUMN_MIN_X,
+	COLUMN_MAX_X,
+	COLUMN_MIN_Y,
+	COLUMN_MAX_Y,
+	COLUMN_X0,
+	COLUMN_Y0,
+	COLUMN_X1,
+	COLUMN_Y1,
+};
+
+static const char select_overlapping_bounds_sql[] = "SELECT entity_id, min_x, max_x, min_y, max_y FROM entity_bounds WHERE max_x >= ?1 AND min_x <= ?3 AND max_y >= ?2 AND min_y <= ?4";
+
+struct entities_in_rect_vtab : public sqlite3_vtab {
+	sqlite3 *db;
+	// Statement reused by the next cursor, so that queries don't prepare it every time
+	sqlite3_stmt *available_stmt;
+};
+
+struct entities_in_rect_cursor : public sqlite3_vtab_cursor {
+	sqlite3_stmt *stmt;
+	bool eof;
+};
+
+static int entities_in_rect_connect(sqlite3 *db, void *aux, int argc, const char *const *argv, sqlite3_vtab **out_vtab, char **out_error) {
+	int res = sqlite3_declare_vtab(db, "CREATE TABLE x(entity_id, min_x, max_x, min_y, max_y, x0 HIDDEN, y0 HIDDEN, x1 HIDDEN, y1 HIDDEN)");
+	if (res != SQLITE_OK) {
+		return res;
+	}
+	entities_in_rect_vtab *vtab = (entities_in_rect_vtab *) sqlite3_malloc(sizeof(entities_in_rect_vtab));
+	if (!vtab) {
+		return SQLITE_NOMEM;
+	}
+	memset(vtab, 0, sizeof(entities_in_rect_vtab));
+	vtab->db = db;
+	*out_vtab = vtab;
+	return SQLITE_OK;
+}
+
+static int entities_in_rect_disconnect(sqlite3_vtab *base_vtab) {
+	entities_in_rect_vtab *vtab = (entities_in_rect_vtab *) base_vtab;
+	sqlite3_finalize(vtab->available_stmt);
+	sqlite3_free(vtab);
+	return SQLITE_OK;
+}
+
+// All 4 rect corners are required
+static int entities_in_rect_best_index(sqlite3_vtab *vtab, sqlite3_index_info *index_info) {
+	int rect_constraints[4] = { -1, -1, -1, -1 };
+	for (int i = 0; i < index_info->nConstraint; i++) {
+		const auto& constraint = index_info->aConstraint[i];
+		if (constraint.op != SQLITE_INDEX_CONSTRAINT_EQ || constraint.iColumn < COLUMN_X0) {
+			continue;
+		}
+		if (!constraint.usable) {
+			return SQLITE_CONSTRAINT;
+		}
+		rect_constraints[constraint.iColumn - COLUMN_X0] = i;
+	}
+	for (int i = 0; i < 4; i++) {
+		if (rect_constraints[i] < 0) {
+			sqlite3_free(vtab->zErrMsg);
+			vtab->zErrMsg = sqlite3_mprintf("entities_in_rect() requires x0, y0, x1 and y1");
+			return SQLITE_ERROR;
+		}
+		index_info->aConstraintUsage[rect_constraints[i]].argvIndex = i + 1;
+		index_info->aConstraintUsage[rect_constraints[i]].omit = 1;
+	}
+	index_info->estimatedCost = 100;
+	return SQLITE_OK;
+}
+
+static int entities_in_rect_open(sqlite3_vtab *base_vtab, sqlite3_vtab_cursor **out_cursor) {
+	entities_in_rect_vtab *vtab = (entities_in_rect_vtab *) base_vtab;
+	sqlite3_stmt *stmt = vtab->available_stmt;
+	vtab->available_stmt = nullptr;
+	if (!stmt) {
+		int res = sqlite3_prepare_v3(vtab->db, select_overlapping_bounds_sql, sizeof(select_overlapping_bounds_sql), SQLITE_PREPARE_PERSISTENT, &stmt, nullptr);
+		if (res != SQLITE_OK) {
+			sqlite3_free(vtab->zErrMsg);
+			vtab->zErrMsg = sqlite3_mprintf("%s", sqlite3_errmsg(vtab->db));
+			return res;
+		}
+	}
+	entities_in_rect_cursor *cursor = new entities_in_rect_cursor();
+	cursor->stmt = stmt;
+	cursor->eof = true;
+	*out_cursor = cursor;
+	return SQLITE_OK;
+}
+
+static int entities_in_rect_close(sqlite3_vtab_cursor *base_cursor) {
+	entities_in_rect_cursor *cursor = (entities_in_rect_cursor *) base_cursor;
+	entities_in_rect_vtab *vtab = (entities_in_rect_vtab *) base_cursor->pVtab;
+	sqlite3_reset(cursor->stmt);
+	if (vtab->available_stmt) {
+		sqlite3_finalize(cursor->stmt);
+	}
+	else {
+		vtab->available_stmt = cursor->stmt;
+	}
+	delete cursor;
+	return SQLITE_OK;
+}
+
+static int entities_in_rect_step(entities_in_rect_cursor *cursor) {
+	int res = sqlite3_step(cursor->stmt);
+	cursor->eof = res != SQLITE_ROW;
+	return res == SQLITE_ROW || res == SQLITE_DONE ? SQLITE_OK : res;
+}
+
+static int entities_in_rect_filter(sqlite3_vtab_cursor *base_cursor, int index_num, const char *index_str, int argc, sqlite3_value **argv) {
+	entities_in_rect_cursor *cursor = (entities_in_rect_cursor *) base_cursor;
+	sqlite3_reset(cursor->stmt);
+	for (int i = 0; i < argc; i++) {
+		sqlite3_bind_value(cursor->stmt, i + 1, argv[i]);
+	}
+	return entities_in_rect_step(cursor);
+}
+
+static int entities_in_rect_next(sqlite3_vtab_cursor *base_cursor) {
+	return entities_in_rect_step((entities_in_rect_cursor *) base_cursor);
+}
+
+static int entities_in_rect_eof(sqlite3_vtab_cursor *base_cursor) {
+	return ((entities_in_rect_cursor *) base_cursor)->eof;
+}
+
+static int entities_in_rect_column(sqlite3_vtab_cursor *base_cursor, sqlite3_context *ctx, int column) {
+	entities_in_rect_cursor *cursor = (entities_in_rect_cursor *) base_cursor;
+	if (column <= COLUMN_MAX_Y) {
+		sqlite3_result_value(ctx, sqlite3_column_value(cursor->stmt, column));
+	}
+	return SQLITE_OK;
+}
+
+static int entities_in_rect_rowid(sqlite3_vtab_cursor *base_cursor, sqlite3_int64 *out_rowid) {
+	*out_rowid = sqlite3_column_int64(((entities_in_rect_cursor *) base_cursor)->stmt, COLUMN_ENTITY_ID);
+	return SQLITE_OK;
+}
+
+static sqlite3_module entities_in_rect_module = {
+	0,                            // iVersion
+	nullptr,                      // xCreate: eponymous-only
+	entities_in_rect_connect,     // xConnect
+	entities_in_rect_best_index,  // xBestIndex
+	entities_in_rect_disconnect,  // xDisconnect
+	nullptr,                      // xDestroy
+	entities_in_rect_open,        // xOpen
+	entities_in_rect_close,       // xClose
+	entities_in_rect_filter,      // xFilter
+	entities_in_rect_next,        // xNext
+	entities_in_rect_eof,         // xEof
+	entities_in_rect_column,      // xColumn
+	entities_in_rect_rowid,       // xRowid
+};
+
+void register_spatial_index(ecsql::World& world) {
+	for (const char *component : bounds_components) {
+		world.track_changes(component);
+	}
+	world.register_connection_setup([](sqlite3 *db) {
+		sqlite3_create_module(db, "entities_in_rect", &entities_in_rect_module, nullptr);
+	});
+
+	// Each sync covers changes since the frame of the last sync, so it also catches changes
+	// made after this system ran in that frame, like the ones from Lua scripts.
+	// The first sync indexes every entity, including the ones created before changes were tracked.
+	// Rectangle wins over Position when an entity has both.
+	// Sprites without Size are drawn with their source rect size, so they are indexed with it too.
+	world.register_system({
+		"UpdateSpatialIndex",
+		{
+			R"(
+				DELETE FROM entity_bounds
+				WHERE entity_id IN (
+					SELECT entity_id FROM Changed('Position', ?1) WHERE removed
+					UNION
+					SELECT entity_id FROM Changed('Rectangle', ?1) WHERE removed
+				)
+					AND entity_id NOT IN (SELECT entity_id FROM Position)
+					AND entity_id NOT IN (SELECT entity_id FROM Rectangle)
+			)"_dedent,
+			// Rotated bounds use the distance from the pivot to the farthest corner in L1 norm,
+			// which covers every rotation without needing `sqrt`
+			R"(
+				WITH
+					changed(entity_id) AS (
+						SELECT entity_id FROM Changed('Position', ?1)
+						UNION SELECT entity_id FROM Changed('Size', ?1)
+						UNION SELECT entity_id FROM Changed('Scale', ?1)
+						UNION SELECT entity_id FROM Changed('Pivot', ?1)
+						UNION SELECT entity_id FROM Changed('Rotation', ?1)
+						UNION SELECT entity_id FROM Changed('Rectangle', ?1)
+						UNION SELECT entity_id FROM Changed('Sprite', ?1)
+						UNION SELECT entity_id FROM Position WHERE ?2
+					),
+					extents AS (
+						SELECT
+							entity_id,
+							Position.x AS x, Position.y AS y,
+							coalesce(Size.width, SpriteWidth(Sprite.path), 0) * coalesce(Scale.x, 1) AS width,
+							coalesce(Size.height, SpriteHeight(Sprite.path), 0) * coalesce(Scale.y, 1) AS height,
+							coalesce(Pivot.x, 0.5) AS pivot_x,
+							coalesce(Pivot.y, 0.5) AS pivot_y,
+							coalesce(Rotation.z, 0) != 0 AS is_rotated
+						FROM changed
+							JOIN Position USING(entity_id)
+							LEFT JOIN Size USING(entity_id)
+							LEFT JOIN Sprite USING(entity_id)
+							LEFT JOIN Scale USING(entity_id)
+							LEFT JOIN Pivot USING(entity_id)
+							LEFT JOIN Rotation USING(entity_id)
+						WHERE entity_id NOT IN (SELECT entity_id FROM Rectangle)
+					),
+					radius AS (
+						SELECT
+							*,
+							abs(width) * max(pivot_x, 1 - pivot_x) + abs(height) * max(pivot_y, 1 - pivot_y) AS r
+						FROM extents
+					)
+				INSERT OR REPLACE INTO entity_bounds(entity_id, min_x, max_x, min_y, max_y)
+				SELECT
+					entity_id,
+					iif(is_rotated, x - r, x - width * pivot_x),
+					iif(is_rotated, x + r, x + width * (1 - pivot_x)),
+					iif(is_rotated, y - r, y - height * pivot_y),
+					iif(is_rotated, y + r, y + height * (1 - pivot_y))
+				FROM radius
+			)"_dedent,
+			R"(
+				INSERT OR REPLACE INTO entity_bounds(entity_id, min_x, max_x, min_y, max_y)
+				SELECT entity_id, x, x + width, y, y + height
+				FROM (
+					SELECT entity_id FROM Changed('Rectangle', ?1)
+					UNION SELECT entity_id FROM Rectangle WHERE ?2
+				)
+					JOIN Rectangle USING(entity_id)
+			)"_dedent,
+		},
+		[&world, last_synced_frame = std::optional<uint64_t>()](std::vector<ecsql::PreparedSQL>& sqls) mutable {
+			auto delete_removed = sqls[0];
+			auto upsert_positioned = sqls[1];
+			auto upsert_rectangles = sqls[2];
+			bool is_full_sync = !last_synced_frame;
+			sqlite3_int64 since = is_full_sync ? -1 : (sqlite3_int64) *last_synced_frame - 1;
+			delete_removed(since);
+			upsert_positioned(since, is_full_sync);
+			upsert_rectangles(since, is_full_sync);
+			last_synced_frame = world.get_frame();
+		},
+	});
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include "../ecsql/world.hpp"
+
+// Keeps `entity_bounds` in sync with Position, Size, Scale, Pivot, Rotation and Rectangle,
+// and registers the `entities_in_rect(x0, y0, x1, y1)` table-valued function.
+// Must be registered before systems that read `entity_bounds` in the same frame.
+void register_spatial_index(ecsql::World& world);
@@ -0,0 +1,208 @@
+#include <algorithm>
+#include <cmath>
+#include <optional>
+
+#include <rlgl.h>
+#include <tracy/Tracy.hpp>
+
+#include "sprite_render_queue.hpp"
+
+// How many batches back a sprite may look for one with its texture
+static const int MAX_BATCH_LOOKBACK = 8;
+
+// Same vertices and texture coordinates as raylib's `DrawTexturePro`, without setting the texture
+static void emit_quad(const SpriteInstance& sprite) {
+	Rectangle source = sprite.source;
+	Rectangle dest = sprite.dest;
+	float width = (float) sprite.texture_width;
+	float height = (float) sprite.texture_height;
+
+	bool flip_x = false;
+	if (source.width < 0) {
+		flip_x = true;
+		source.width *= -1;
+	}
+	if (source.height < 0) {
+		source.y -= source.height;
+	}
+	if (dest.width < 0) {
+		dest.width *= -1;
+	}
+	if (dest.height < 0) {
+		dest.height *= -1;
+	}
+
+	Vector2 top_left, top_right, bottom_left, bottom_right;
+	if (sprite.rotation == 0) {
+		float x = dest.x - sprite.pivot.x;
+		float y = dest.y - sprite.pivot.y;
+		top_left = { x, y };
+		top_right = { x + dest.width, y };
+		bottom_left = { x, y + dest.height };
+		bottom_right = { x + dest.width, y + dest.height };
+	}
+	else {
+		float sin_rotation = sinf(sprite.rotation * DEG2RAD);
+		float cos_rotation = cosf(sprite.rotation * DEG2RAD);
+		float x = dest.x;
+		float y = dest.y;
+		float dx = -sprite.pivot.x;
+		float dy = -sprite.pivot.y;
+		top_left = {
+			x + dx * cos_rotation - dy * sin_rotation,
+			y + dx * sin_rotation + dy * cos_rotation,
+		};
+		top_right = {
+			x + (dx + dest.width) * cos_rotation - dy * sin_rotation,
+			y + (dx + dest.width) * sin_rotation + dy * cos_rotation,
+		};
+		bottom_left = {
+			x + dx * cos_rotation - (dy + dest.height) * sin_rotation,
+			y + dx * sin_rotation + (dy + dest.height) * cos_rotation,
+		};
+		bottom_right = {
+			x + (dx + dest.width) * cos_rotation - (dy + dest.height) * sin_rotation,
+			y + (dx + dest.width) * sin_rotation + (dy + dest.height) * cos_rotation,
+		};
+	}
+
+	float left = source.x / width;
+	float right = (source.x + source.width) / width;
+	if (flip_x) {
+		std::swap(left, right);
+	}
+	float top = source.y / height;
+	float bottom = (source.y + source.height) / height;
+
+	// Flushes the batch if it is full, keeping the current texture and draw mode
+	rlCheckRenderBatchLimit(4);
+	rlColor4ub(sprite.color.r, sprite.color.g, sprite.color.b, sprite.color.a);
+	rlNormal3f(0, 0, 1);
+	rlTexCoord2f(left, top);
+	rlVertex2f(top_left.x, top_left.y);
+	rlTexCoord2f(left, bottom);
+	rlVertex2f(bottom_left.x, bottom_left.y);
+	rlTexCoord2f(right, bottom);
+	rlVertex2f(bottom_right.x, bottom_right.y);
+	rlTexCoord2f(right, top);
+	rlVertex2f(top_right.x, top_right.y);
+}
+
+// Axis aligned bounds of the drawn quad. Rotated quads use the distance from the pivot to
+// the farthest corner in L1 norm, which covers every rotation without needing `sqrt`.
+static void get_bounds(const SpriteInstance& sprite, float& min_x, float& min_y, float& max_x, float& max_y) {
+	float width = fabsf(sprite.dest.width);
+	float height = fabsf(sprite.dest.height);
+	if (sprite.rotation == 0) {
+		min_x = sprite.dest.x - sprite.pivot.x;
+		min_y = sprite.dest.y - sprite.pivot.y;
+		max_x = min_x + width;
+		max_y = min_y + height;
+	}
+	else {
+		float r = std::max(fabsf(sprite.pivot.x), fabsf(width - sprite.pivot.x)) + std::max(fabsf(sprite.pivot.y), fabsf(height - sprite.pivot.y));
+		min_x = sprite.dest.x - r;
+		min_y = sprite.dest.y - r;
+		max_x = sprite.dest.x + r;
+		max_y = sprite.dest.y + r;
+	}
+}
+
+void SpriteRenderQueue::push(const Texture2D& texture, Rectangle source, Rectangle dest, Vector2 pivot, float rotation, Color color, int layer) {
+	if (texture.id == 0) {
+		return;
+	}
+	instances.push_back({
+		texture.id,
+		texture.width,
+		texture.height,
+		source,
+		dest,
+		pivot,
+		rotation,
+		color,
+		layer,
+		0,
+	});
+}
+
+void SpriteRenderQueue::assign_batches() {
+	batches.clear();
+	for (SpriteInstance& sprite : instances) {
+		float min_x, min_y, max_x, max_y;
+		get_bounds(sprite, min_x, min_y, max_x, max_y);
+
+		// Walk back over batches this sprite doesn't overlap, looking for one with the same texture
+		std::optional<size_t> found;
+		for (size_t i = batches.size(), lookback = 0; i > 0 && lookback < MAX_BATCH_LOOKBACK; i--, lookback++) {
+			const SpriteBatch& batch = batches[i - 1];
+			if (batch.layer != sprite.layer) {
+				break;
+			}
+			if (batch.texture_id == sprite.texture_id) {
+				found = i - 1;
+				break;
+			}
+			bool overlaps = min_x < batch.max_x && max_x > batch.min_x && min_y < batch.max_y && max_y > batch.min_y;
+			if (overlaps) {
+				break;
+			}
+		}
+
+		if (found) {
+			SpriteBatch& batch = batches[*found];
+			batch.min_x = std::min(batch.min_x, min_x);
+			batch.min_y = std::min(batch.min_y, min_y);
+			batch.max_x = std::max(batch.max_x, max_x);
+			batch.max_y = std::max(batch.max_y, max_y);
+			sprite.batch = (uint32_t) *found;
+		}
+		else {
+			sprite.batch = (uint32_t) batches.size();
+			batches.push_back({ sprite.texture_id, sprite.layer, min_x, min_y, max_x, max_y });
+		}
+	}
+}
+
+int SpriteRenderQueue::flush() {
+	ZoneScoped;
+	if (instances.empty()) {
+		return 0;
+	}
+
+	{
+		ZoneScopedN("sort");
+		// Sprites in the same layer keep their submission order, for it decides which one is drawn on top
+		std::stable_sort(instances.begin(), instances.end(), [](const SpriteInstance& a, const SpriteInstance& b) {
+			return a.layer < b.layer;
+		});
+		assign_batches();
+		std::stable_sort(instances.begin(), instances.end(), [](const SpriteInstance& a, const SpriteInstance& b) {
+			return a.batch < b.batch;
+		});
+	}
+
+	int batch_count = 0;
+	std::optional<uint32_t> current_batch;
+	for (const SpriteInstance& sprite : instances) {
+		if (sprite.batch != current_batch) {
+			if (current_batch) {
+				rlEnd();
+			}
+			current_batch = sprite.batch;
+			rlSetTexture(sprite.texture_id);
+			rlBegin(RL_QUADS);
+			batch_count++;
+		}
+		emit_quad(sprite);
+	}
+	rlEnd();
+	rlSetTexture(0);
+
+	instances.clear();
+	return batch_count;
+}
+
+size_t SpriteRenderQueue::size() const {
+	return instances.size();
+}
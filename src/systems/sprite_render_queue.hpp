@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <raylib.h>
+
+// Compact sprite draw command, as accepted by `DrawTexturePro`
+struct SpriteInstance {
+	unsigned int texture_id;
+	int texture_width;
+	int texture_height;
+	Rectangle source;
+	Rectangle dest;
+	Vector2 pivot;
+	float rotation;
+	Color color;
+	int layer;
+	// Index of the texture batch the sprite is drawn in, assigned by `flush`
+	uint32_t batch;
+};
+
+// Texture batch being built by `flush`, with the bounds of all its sprites
+struct SpriteBatch {
+	unsigned int texture_id;
+	int layer;
+	float min_x, min_y, max_x, max_y;
+};
+
+// Per-frame sprite buffer, drawn sorted by layer, then in submission order.
+// Sprites sharing a texture go into a single rlgl quad batch instead of one `DrawTexturePro` each.
+// A sprite only joins an earlier batch of its texture if it doesn't overlap anything drawn since,
+// so batching never changes what is drawn on top.
+class SpriteRenderQueue {
+public:
+	void push(const Texture2D& texture, Rectangle source, Rectangle dest, Vector2 pivot, float rotation, Color color, int layer = 0);
+	// Draw and clear all queued sprites. Returns the number of texture batches submitted.
+	int flush();
+
+	size_t size() const;
+
+private:
+	std::vector<SpriteInstance> instances;
+	std::vector<SpriteBatch> batches;
+
+	void assign_batches();
+};
@@ -1,5 +1,7 @@
+#include <span>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include <cdedent.hpp>
 #include <flyweight.hpp>
@@ -7,8 +9,13 @@
 #include <yoga/Yoga.h>
 
 #include "yoga.hpp"
+#include "../ecsql/component.hpp"
 #include "../ecsql/hook_system.hpp"
 #include "../ecsql/system.hpp"
+#include "../ecsql/world.hpp"
+
+// Defined in components.cpp
+extern ecsql::Component RectangleComponent;
 
 enum YogaNodeColumn {
 	YogaNode_entity_id,
@@ -519,10 +526,15 @@ ecsql::HookSystem TextHookSystem {
 	},
 };
 
-void recurse_update_rect(YGNodeRef node, ecsql::PreparedSQL& upsert_rectangle) {
-	upsert_rectangle(YogaNodeContext::get(node)->entity_id, YGNodeLayoutGetLeft(node), YGNodeLayoutGetTop(node), YGNodeLayoutGetWidth(node), YGNodeLayoutGetHeight(node));
+struct RectangleRow {
+	ecsql::EntityID entity_id;
+	float x, y, width, height;
+};
+
+void recurse_collect_rect(YGNodeRef node, std::vector<RectangleRow>& rects) {
+	rects.push_back({ YogaNodeContext::get(node)->entity_id, YGNodeLayoutGetLeft(node), YGNodeLayoutGetTop(node), YGNodeLayoutGetWidth(node), YGNodeLayoutGetHeight(node) });
 	for (size_t i = 0, count = YGNodeGetChildCount(node); i < count; i++) {
-		recurse_update_rect(YGNodeGetChild(node, i), upsert_rectangle);
+		recurse_collect_rect(YGNodeGetChild(node, i), rects);
 	}
 }
 
@@ -568,15 +580,11 @@ void register_update_yoga(ecsql::World& world) {
 				JOIN screen
 				WHERE parent_id IS NULL
 			)"_dedent,
-			R"(
-				INSERT INTO Rectangle(entity_id, x, y, width, height)
-				VALUES(?1, ?2, ?3, ?4, ?5)
-				ON CONFLICT DO UPDATE SET x = ?2, y = ?3, width = ?4, height = ?5
-			)",
 		},
-		[](auto& sqls) {
+		[](ecsql::World& world, std::vector<ecsql::PreparedSQL>& sqls) {
+			// Reused across frames, so that layouts don't allocate once it has grown
+			static std::vector<RectangleRow> rects;
 			auto get_root_yoga_entities = sqls[0];
-			auto upsert_rectangle = sqls[1];
 			for (ecsql::SQLRow row : get_root_yoga_entities()) {
 				auto entity_id = row.get<ecsql::EntityID>(0);
 				auto node = YogaNodeFlyweight.get_autorelease(entity_id);
@@ -590,8 +598,10 @@ void register_update_yoga(ecsql::World& world) {
 					YGNodeCalculateLayout(node, width, height, YGDirectionInherit);
 				}
 				{
-					ZoneScopedN("recurse_update_rect");
-					recurse_update_rect(node, upsert_rectangle);
+					ZoneScopedN("update_rects");
+					rects.clear();
+					recurse_collect_rect(node, rects);
+					RectangleComponent.upsert_many(world, std::span<const RectangleRow>(rects));
 				}
 			}
 		},